@@ -79,10 +79,14 @@ enum regAddr
       MD2_CFG           = 0x5F,
 };
 
+// the chip's I2C address, for transfers queued with i2c_submit
+extern const unsigned lsm6ds33_address;
+
 void lsm6ds33_init();
 
 void lsm6ds33_write_reg(unsigned char reg, unsigned char v);
 unsigned lsm6ds33_read_reg(unsigned char reg);
+void lsm6ds33_read_regs(unsigned char reg, unsigned char *data, int len);
 
 unsigned lsm6ds33_get_whoami(); 
 
@@ -91,5 +95,9 @@ void lsm6ds33_read_gyroscope(short *x, short *y, short *z);
 
 void lsm6ds33_enable_accelerometer();
 void lsm6ds33_read_accelerometer(short *x, short *y, short *z);
+void lsm6ds33_read_sample(short gyro[3], short accel[3]); // both in one transfer
+
+// x, y and z from the six bytes the chip sends for one sensor, e.g. from its FIFO
+void lsm6ds33_unpack_xyz(const unsigned char *data, short xyz[3]);
 
 #endif
@@ -12,6 +12,8 @@
  * implemented in assign5
  */
 
+#include "input.h"
+
 // The moves we can register
 enum moves {
     MOVE_FORWARD,
@@ -20,17 +22,55 @@ enum moves {
     TURN_RIGHT,
     MOVE_RIGHT,
     MOVE_LEFT,
+    PICK_BEEPER,
+    PUT_BEEPER,
 };
 
+// plays the moves made by tilting and turning the board
+extern const input_source_t input_sensor;
+
 /*
  * 'accel_init'
  *
- * Initialises the accelerometer to be used.
+ * Initialises the accelerometer to be used and
+ * turns on interrupts (see timer_init), so sensor
+ * samples are read in the background. The sensor
+ * is calibrated first, so the board should lie
+ * still for a moment (see calibration.h). Once
+ * the sensor is running, later calls do nothing.
+ *
+ * @params  none
+ * @returns 1 if the sensor is running, 0 if no
+ *          LSM6DS33 answered on the I2C bus
+ */
+int accel_init(void);
+
+/*
+ * 'accel_poll_move'
+ *
+ * Takes the oldest move recognised so far (see
+ * gesture.h and move_queue.h), without waiting. The
+ * sensor's samples are fetched in the background
+ * whenever its INT1 pin says a few are ready, or, if
+ * INT1 is not wired to GPIO 17, on each poll; moves
+ * found in them are queued for later polls. A held
+ * tilt steps again every so often.
+ *
+ * @params  none
+ * @returns move being made, or -1 if none
+ */
+int accel_poll_move(void);
+
+/*
+ * 'accel_uses_int1'
  *
  * @params  none
- * @returns none
+ * @returns 1 if the sensor's INT1 pin was found on GPIO
+ *          17 and starts the drains, 0 if polls start
+ *          them
+ * @precon  accel_init was called
  */
-void accel_init(void);
+int accel_uses_int1(void);
 
 /*
  * 'accel_read_move'
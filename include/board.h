@@ -20,31 +20,141 @@ typedef struct board_config {
     int display_size; // dimension of square board to be displayed
 } board_config_t;
 
+// largest board the engine supports
+#define BOARD_MAX_ROWS 128
+#define BOARD_MAX_COLS 128
+
 // convention used to encode walls
 enum {
     FREE = '-',
     SOUTH_WALL = 's',
     WEST_WALL = 'w',
+    CORNER_WALL = 'c', // walls to the south and west
     BEEPER = 'b',
     PAT = 'p',
     JULIE = 'z',
 };
 
 // directions
-enum {EAST, NORTH, WEST, SOUTH} directions;
+enum directions {EAST, NORTH, WEST, SOUTH};
+
+// bit for the wall on one side of a cell (see board_walls)
+#define WALL_BIT(dir) (1 << (dir))
 
 /* 
  * 'board_init'
  *
- * Initialises the board 
+ * Initialises the board and builds the index
+ * of its special tiles (see tiles.h). The board is
+ * copied, so the caller's strings are not modified
+ * by board_set_tile.
  *
  * @params  board, number of rows in board, and length of square
  *          display on console
  * @returns none
- * @precon  board must be rectangular
+ * @precon  board must be rectangular and fit in
+ *          BOARD_MAX_ROWS x BOARD_MAX_COLS
  */
 void board_init(const char *input_board[], int nrows, int display_dim);
 
+/*
+ * 'board_load'
+ *
+ * Loads a board without touching the screen. Used by
+ * board_init, and directly by headless builds.
+ *
+ * @params  board, number of rows in board, and length of square
+ *          display on console
+ * @returns none
+ * @precon  board must be rectangular and fit in
+ *          BOARD_MAX_ROWS x BOARD_MAX_COLS
+ */
+void board_load(const char *input_board[], int nrows, int display_dim);
+
+/*
+ * 'board_new'
+ *
+ * Replaces the loaded board with an empty one of the
+ * given size, e.g. to be filled in by maze.h. Keeps
+ * the display set up by board_init.
+ *
+ * @params  number of rows and columns
+ * @returns none
+ * @precon  size must fit in BOARD_MAX_ROWS x BOARD_MAX_COLS
+ */
+void board_new(int nrows, int ncols);
+
+/*
+ * 'board_get_config'
+ *
+ * @params  none
+ * @returns the board currently loaded by board_init
+ */
+const board_config_t *board_get_config(void);
+
+/*
+ * 'board_set_tile'
+ *
+ * Changes one tile of the loaded board and keeps the
+ * tile index and wall masks up to date. Callers that
+ * keep derived data (e.g. distfield.h) must update
+ * it as well.
+ *
+ * @params  x and y position, new tile
+ * @returns none
+ */
+void board_set_tile(int x, int y, char tile);
+
+/*
+ * 'board_set_wall'
+ *
+ * Adds or removes the wall on one side of a cell,
+ * in both cells it separates. Walls on the edge of
+ * the board cannot be removed. Callers that keep
+ * derived data (e.g. distfield.h) must update it.
+ *
+ * @params  x and y position, side of the cell,
+ *          1 to add the wall or 0 to remove it
+ * @returns none
+ */
+void board_set_wall(int x, int y, int dir, int present);
+
+/*
+ * 'board_walls'
+ *
+ * @params  x and y position on the board
+ * @returns walls around the cell, WALL_BIT(dir) for
+ *          each side that has one (including the
+ *          edges of the board)
+ */
+int board_walls(int x, int y);
+
+/*
+ * 'board_can_move'
+ *
+ * Checks whether Karel can move one step from (x, y)
+ * in the given direction without leaving the board
+ * or walking through a wall, with one bit test.
+ *
+ * @params  Karel's x and y position, direction
+ * @returns 1 if the move is valid, 0 otherwise
+ * @precon  (x, y) must be on the board
+ */
+int board_can_move(int x, int y, int dir);
+
+/*
+ * 'board_set_hint'
+ *
+ * Sets the cells highlighted by draw_board as a hint
+ * overlay (e.g. the next steps of a shortest path).
+ * The cells are copied; pass count 0 to clear.
+ *
+ * @params  array of x positions, array of y positions,
+ *          number of cells
+ * @returns none
+ */
+void board_set_hint(const int *xs, const int *ys, int count);
+
 /* 
  * 'draw_start'
  *
@@ -71,6 +181,10 @@ void draw_end();
  * array of characters (look in board.c to see 
  * convention used to encode Karel's world).
  *
+ * Redraws the whole screen, so call it whenever
+ * the tiles changed; draw_karel_move is much
+ * cheaper for frames where only Karel moves.
+ *
  * @params  Karel's x position, Karel's y position
  *          direction Karel is facing
  * @returns none
@@ -78,4 +192,26 @@ void draw_end();
  */
 void draw_board(int karel_x, int karel_y, int direction);
 
+// steps in one move, see draw_karel_move
+#define KAREL_MOVE_STEPS 256
+
+/*
+ * 'draw_karel_move'
+ *
+ * Draws one frame of Karel moving: sliding from one
+ * cell to the next, or turned part of the way to his
+ * new direction. Only the cells Karel covers in this
+ * frame or the last one are redrawn, unless the board
+ * had to scroll.
+ *
+ * @params  Karel's x, y and direction before the move,
+ *          the same after it, and how far along the
+ *          move is (0 to KAREL_MOVE_STEPS)
+ * @returns none
+ * @precon  the tiles must not have changed since the
+ *          last draw_board
+ */
+void draw_karel_move(int from_x, int from_y, int from_dir,
+                     int to_x, int to_y, int to_dir, int progress);
+
 #endif
@@ -0,0 +1,43 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+/*
+ * FILENAME: calibration.h
+ * -------------------------------------------------
+ * Works out how far a sensor's readings are off, and
+ * how noisy they are, from samples taken while the
+ * board lies flat and still. Every chip is a little
+ * different: at rest the gyroscope reads a few
+ * degrees per second and the accelerometer not quite
+ * 1 g. gesture.h uses the result to correct samples
+ * and to widen its thresholds on noisy boards.
+ */
+
+#include "sensor_fifo.h"
+
+// accelerometer counts for 1 g (+-2 g range)
+#define CALIBRATION_ONE_G 16384
+
+// what a sensor reads at rest, in counts, x, y and z
+typedef struct calibration {
+    short gyro_bias[3];   // should be 0
+    short accel_bias[3];  // from 0, 0 and CALIBRATION_ONE_G
+    short gyro_noise[3];  // standard deviation
+    short accel_noise[3];
+} calibration_t;
+
+/*
+ * 'calibration_compute'
+ *
+ * Averages the samples and measures their spread.
+ * Samples that look like the board was moving, or not
+ * lying flat, are refused so the defaults stay.
+ *
+ * @params  samples taken at rest, how many (at least
+ *          16), where to put the result
+ * @returns 1 if the result was filled in, 0 if the
+ *          samples were refused
+ */
+int calibration_compute(const sensor_sample_t *samples, int n, calibration_t *cal);
+
+#endif
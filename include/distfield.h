@@ -0,0 +1,60 @@
+#ifndef DISTFIELD_H
+#define DISTFIELD_H
+
+/*
+ * FILENAME: distfield.h
+ * -------------------------------------------------
+ * Keeps the number of actions (move() or turn_left())
+ * from every position and direction on the board to
+ * the nearest beeper. The field is computed once per
+ * level with one reverse breadth-first search, after
+ * which hints and "moves remaining" are O(1) lookups.
+ */
+
+#include "karel_sim.h"
+
+/*
+ * 'distfield_compute'
+ *
+ * Computes the whole field for the board currently
+ * loaded by board_init.
+ *
+ * @params  none
+ * @returns none
+ */
+void distfield_compute(void);
+
+/*
+ * 'distfield_update'
+ *
+ * Repairs the field after the tile at (x, y) changed
+ * through board_set_tile (a wall or beeper was added
+ * or removed). Only positions whose distance actually
+ * changes are visited.
+ *
+ * @params  x and y position of the changed tile
+ * @returns none
+ */
+void distfield_update(int x, int y);
+
+/*
+ * 'distfield_get'
+ *
+ * @params  Karel's position and direction
+ * @returns fewest actions needed to reach a beeper,
+ *          or -1 if no beeper can be reached
+ */
+int distfield_get(pos_t pos);
+
+/*
+ * 'distfield_next_move'
+ *
+ * @params  Karel's position and direction
+ * @returns the first action (MOVE_FORWARD or TURN_LEFT,
+ *          see accel.h) of a shortest path to a beeper,
+ *          or -1 if Karel is on a beeper or no beeper
+ *          can be reached
+ */
+int distfield_next_move(pos_t pos);
+
+#endif
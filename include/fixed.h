@@ -0,0 +1,88 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+/*
+ * FILENAME: fixed.h
+ * -------------------------------------------------
+ * Fixed-point numbers in Q16.16: an int holding the
+ * value times 65536, so from about -32768 to 32768 in
+ * steps of 1/65536. The ARM1176 has no floating point
+ * unit enabled in our build, so every float operation
+ * is a libgcc call; these are a few instructions each.
+ *
+ * Multiplication and saturating addition are inline,
+ * as they are used once or more per sample and per
+ * pixel.
+ */
+
+typedef int fixed_t;
+
+#define FIXED_SHIFT 16
+#define FIXED_ONE   (1 << FIXED_SHIFT)
+#define FIXED_MAX   0x7fffffff
+#define FIXED_MIN   (-FIXED_MAX - 1)
+
+// conversions; FIXED_TO_INT rounds toward minus infinity
+#define FIXED_FROM_INT(n)       ((fixed_t) ((n) * FIXED_ONE))
+#define FIXED_FROM_RATIO(n, d)  ((fixed_t) ((long long) (n) * FIXED_ONE / (d)))
+#define FIXED_TO_INT(f)         ((f) >> FIXED_SHIFT)
+#define FIXED_FRAC(f)           ((f) & (FIXED_ONE - 1))
+
+/*
+ * 'fixed_mul'
+ *
+ * @params  two numbers
+ * @returns their product, rounded to nearest
+ * @precon  the product fits in Q16.16
+ */
+static inline fixed_t fixed_mul(fixed_t a, fixed_t b) {
+    return ((long long) a * b + (1 << (FIXED_SHIFT - 1))) >> FIXED_SHIFT;
+}
+
+/*
+ * 'fixed_add_sat'
+ *
+ * @params  two numbers
+ * @returns their sum, or FIXED_MAX or FIXED_MIN if
+ *          it does not fit
+ */
+static inline fixed_t fixed_add_sat(fixed_t a, fixed_t b) {
+    fixed_t sum = (unsigned int) a + (unsigned int) b;
+    if (((a ^ sum) & (b ^ sum)) < 0) { // both operands' sign differs from the sum's
+        return a < 0 ? FIXED_MIN : FIXED_MAX;
+    }
+    return sum;
+}
+
+/*
+ * 'fixed_div'
+ *
+ * @params  dividend, divisor
+ * @returns their quotient, rounded toward zero, or
+ *          FIXED_MAX or FIXED_MIN if it does not fit
+ *          or the divisor is 0
+ */
+fixed_t fixed_div(fixed_t a, fixed_t b);
+
+/*
+ * 'fixed_sqrt'
+ *
+ * @params  a number
+ * @returns its square root, rounded down, or 0 for
+ *          negative numbers
+ */
+fixed_t fixed_sqrt(fixed_t a);
+
+/*
+ * 'fixed_atan2'
+ *
+ * Approximates the angle of the point (x, y) from
+ * the x axis, to within 0.3 degrees.
+ *
+ * @params  y and x (in any one scale)
+ * @returns the angle in degrees, -180 to 180, in
+ *          Q16.16; 0 for (0, 0)
+ */
+fixed_t fixed_atan2(fixed_t y, fixed_t x);
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef GESTURE_H
+#define GESTURE_H
+
+/*
+ * FILENAME: gesture.h
+ * -------------------------------------------------
+ * Recognises moves in the stream of sensor samples.
+ * The board's tilt is tracked with a complementary
+ * filter of the gyroscope and the accelerometer, so
+ * a single knock cannot look like a tilt, and the
+ * gyroscope's z axis is integrated, so a turn is only
+ * reported once Karel's board has really turned most
+ * of a quarter. Each gesture has separate thresholds
+ * to start and to end it (hysteresis), and after a
+ * move nothing is reported for a short refractory
+ * window. Holding a tilt repeats the step.
+ *
+ * All the arithmetic is on integers, and the module
+ * only sees samples, so recorded traces can be
+ * replayed through it on the host.
+ */
+
+#include "sensor_fifo.h"
+#include "calibration.h"
+
+/*
+ * 'gesture_init'
+ *
+ * Forgets every earlier sample and any calibration,
+ * and sets the rate the samples will come at.
+ *
+ * @params  sample rate in Hz (e.g. 104 for
+ *          FIFO_RATE_104HZ)
+ * @returns none
+ * @precon  the sensors use the ranges set by
+ *          lsm6ds33_enable_gyroscope and
+ *          lsm6ds33_enable_accelerometer
+ */
+void gesture_init(int rate_hz);
+
+/*
+ * 'gesture_calibrate'
+ *
+ * Corrects later samples for what this board reads
+ * at rest, and keeps the thresholds for turning and
+ * tilting clear of its noise.
+ *
+ * @params  the board's calibration (calibration.h)
+ * @returns none
+ */
+void gesture_calibrate(const calibration_t *cal);
+
+/*
+ * 'gesture_feed'
+ *
+ * Adds the next sample to the recogniser.
+ *
+ * @params  the sample
+ * @returns move recognised with this sample (enum
+ *          moves in accel.h), or -1 if none
+ */
+int gesture_feed(const sensor_sample_t *sample);
+
+#endif
@@ -250,4 +250,23 @@ void gl_draw_line(int x1, int y1, int x2, int y2, color_t c);
 void gl_draw_triangle(int x1, int y1, int x2, int y2, int x3, int y3, color_t c);
 
 void gl_draw_image(const unsigned char ref_img[], int width, int height, int x, int y); 
+
+/*
+ * `gl_draw_image_rotated`
+ *
+ * Draw an image like `gl_draw_image`, turned counterclockwise about
+ * its center. Only pixels inside the width x height box at (x, y)
+ * are drawn, so the corners of the image are cut off while it is
+ * turned part of the way.
+ *
+ * @param ref_img  the image, 3 bytes (r, g, b) per pixel
+ * @param width    the width of the image in pixels
+ * @param height   the height of the image in pixels
+ * @param x        the x location of the upper left corner
+ * @param y        the y location of the upper left corner
+ * @param sin_q12  sine of the angle, times 4096
+ * @param cos_q12  cosine of the angle, times 4096
+ */
+void gl_draw_image_rotated(const unsigned char ref_img[], int width, int height,
+                           int x, int y, int sin_q12, int cos_q12);
 #endif
@@ -7,10 +7,129 @@
  *
  * Author: Anna Zeng <zeng@cs.stanford.edu>
  * Date: May 14, 2016
+ *
+ * Transfers can also be queued with `i2c_submit`, which returns at
+ * once and calls a function when the transfer is over. After
+ * `i2c_interrupts_enable` the queue is worked through by the BSC1
+ * interrupt; before, `i2c_submit` does the transfer itself.
  */
 
+// how a transfer went
+enum i2c_status {
+    I2C_OK = 0,
+    I2C_NACK = -1,          // the peripheral did not acknowledge
+    I2C_CLOCK_TIMEOUT = -2, // the peripheral held the clock too long
+    I2C_INCOMPLETE = -3,    // fewer bytes arrived than asked for
+    I2C_TIMEOUT = -4,       // a transfer did not finish in time
+};
+
+// bus speeds for `i2c_set_clock`
+#define I2C_STANDARD_HZ 100000
+#define I2C_FAST_HZ     400000
+
+// transfer latencies: bucket i counts those of 2^i to 2^(i+1) - 1 us
+#define I2C_LATENCY_BUCKETS 16
+
+// called with the status (enum i2c_status) when a transfer is over
+typedef void (*i2c_done_fn_t)(int status, void *aux);
+
+/*
+ * A queued transfer: writes `write_len` bytes, then reads `read_len`
+ * bytes, either of which may be 0. The transfer and its buffers
+ * must stay valid until `done` is called.
+ */
+typedef struct i2c_xfer {
+    unsigned address;
+    const unsigned char *write;
+    int write_len;
+    unsigned char *read;
+    int read_len;
+    i2c_done_fn_t done;     // may be NULL
+    void *aux;
+} i2c_xfer_t;
+
+// most transfers waiting at once
+#define I2C_QUEUE_SIZE 8
+
+/*
+ * `i2c_init`, `i2c_read`, `i2c_write`
+ *
+ * Sets up BSC1 at I2C_STANDARD_HZ, and reads or writes bytes,
+ * waiting until they are moved. Polled transfers give up after a
+ * time that allows for the bytes at the current clock.
+ *
+ * @return  `i2c_read` and `i2c_write` return how the transfer went
+ *          (enum i2c_status)
+ */
 void i2c_init(void);
-void i2c_read(unsigned peripheral_address, char *data, int data_length);
-void i2c_write(unsigned peripheral_address, char *data, int data_length);
+int i2c_read(unsigned peripheral_address, char *data, int data_length);
+int i2c_write(unsigned peripheral_address, char *data, int data_length);
+
+/*
+ * `i2c_set_clock`
+ *
+ * Sets the bus clock, e.g. I2C_FAST_HZ if every peripheral on the
+ * bus supports fast mode.
+ *
+ * @param hz  the clock in Hz
+ * @precon    no transfer is under way
+ */
+void i2c_set_clock(unsigned int hz);
+
+/*
+ * `i2c_latency_histogram`
+ *
+ * Copies out how long transfers took on the bus, from start to
+ * end, since `i2c_init` or the last `i2c_latency_reset`.
+ *
+ * @param counts  where to put the I2C_LATENCY_BUCKETS counts
+ */
+void i2c_latency_histogram(unsigned int counts[I2C_LATENCY_BUCKETS]);
+void i2c_latency_reset(void);
+
+/*
+ * `i2c_interrupts_enable`
+ *
+ * Works through submitted transfers from the BSC1 interrupt from now
+ * on. `done` functions are then called from the interrupt, so they
+ * must be short and must not call `i2c_read` or `i2c_write`; they
+ * may submit further transfers.
+ *
+ * @precon  `interrupts_init` has been called (see `timer_init`)
+ */
+void i2c_interrupts_enable(void);
+
+/*
+ * `i2c_transfer`
+ *
+ * Does a transfer through the queue and waits for it. Its `done`
+ * and `aux` are replaced. Must not be called from a `done` function.
+ * While waiting it calls `i2c_check_timeouts`, so the wait always
+ * ends.
+ *
+ * @param xfer  the transfer
+ * @return      how it went (enum i2c_status)
+ */
+int i2c_transfer(i2c_xfer_t *xfer);
+
+/*
+ * `i2c_check_timeouts`
+ *
+ * Stops the transfer on the bus with `I2C_TIMEOUT` if it has taken
+ * longer than its bytes should (a stuck bus or a lost interrupt),
+ * and starts the next. Anything that waits on submitted transfers
+ * without `i2c_transfer` should call this as it waits or polls.
+ */
+void i2c_check_timeouts(void);
+
+/*
+ * `i2c_submit`
+ *
+ * Queues a transfer, starting it if the bus is free.
+ *
+ * @param xfer  the transfer
+ * @return      1 if queued, 0 if I2C_QUEUE_SIZE transfers are waiting
+ */
+int i2c_submit(i2c_xfer_t *xfer);
 
 #endif
@@ -0,0 +1,113 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+/*
+ * FILENAME: input.h
+ * -------------------------------------------------
+ * Gathers the player's moves from every source in
+ * use into one stream, so the game does not care
+ * whether a move came from tilting the board (see
+ * accel.h), from the arrow keys of a PS/2 keyboard
+ * (see keys.h) or from a script of moves played back,
+ * e.g. a solver's path on the host.
+ *
+ * A source only has to say, without waiting, which
+ * move was made next, if any. Sources are polled in
+ * turn, starting after the last one to give a move,
+ * so one that always has a move cannot starve the
+ * others.
+ */
+
+// most sources in use at once
+#define INPUT_MAX_SOURCES 4
+
+// a source of moves
+typedef struct input_source {
+    const char *name;
+    int (*init)(void);   // sets the source up, 1 if it is there, or 0
+    int (*poll)(void);   // next move (enum moves in accel.h) or -1, without waiting
+    void (*flush)(void); // forgets moves made so far, or 0
+} input_source_t;
+
+// plays back the moves given to input_script_load
+extern const input_source_t input_script;
+
+/*
+ * 'input_init'
+ *
+ * Stops using every source.
+ *
+ * @params  none
+ * @returns none
+ */
+void input_init(void);
+
+/*
+ * 'input_add'
+ *
+ * Sets a source up and starts taking moves from it.
+ * A source whose init reports it missing, e.g. the
+ * sensor on a board without one, is left out.
+ *
+ * @params  the source, which must outlive its use
+ * @returns 1 if added, 0 if it is missing or
+ *          INPUT_MAX_SOURCES are already in use
+ */
+int input_add(const input_source_t *source);
+
+/*
+ * 'input_poll'
+ *
+ * Takes the next move from the sources, without
+ * waiting.
+ *
+ * @params  none
+ * @returns the move, or -1 if no source has one
+ */
+int input_poll(void);
+
+/*
+ * 'input_read'
+ *
+ * Waits until a source has a move.
+ *
+ * @params  none
+ * @returns the move
+ * @precon  at least one source was added
+ */
+int input_read(void);
+
+/*
+ * 'input_flush'
+ *
+ * Forgets the moves every source has waiting, e.g.
+ * ones made before a game started. Scripts keep
+ * their place.
+ *
+ * @params  none
+ * @returns none
+ */
+void input_flush(void);
+
+/*
+ * 'input_script_load'
+ *
+ * Makes input_script play the moves back from the
+ * first, one per poll.
+ *
+ * @params  the moves (enum moves in accel.h), which
+ *          are not copied, and how many
+ * @returns none
+ */
+void input_script_load(const unsigned char *moves, int n);
+
+/*
+ * 'input_script_left'
+ *
+ * @params  none
+ * @returns number of moves of the script not yet
+ *          played
+ */
+int input_script_left(void);
+
+#endif
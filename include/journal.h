@@ -0,0 +1,110 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+/*
+ * FILENAME: journal.h
+ * -------------------------------------------------
+ * Undo and redo for Karel's moves. Every move that
+ * changed Karel's position or picked or put a beeper
+ * is kept as a 2-bit code, 16 to a word, so even very
+ * long sessions take a few bytes per hundred moves. Undo and redo apply
+ * one move backwards or forwards; jumping to any
+ * step starts from the nearest snapshot, taken every
+ * JOURNAL_SNAPSHOT_EVERY moves, and replays from
+ * there.
+ *
+ * The journal moves Karel through karel_sim_init and
+ * puts beepers back through tiles.h, so it works with
+ * the headless engine on its own.
+ */
+
+#include "karel_sim.h"
+
+// most moves kept before the journal starts over
+#define JOURNAL_MAX_STEPS (1 << 18)
+
+// moves between snapshots of Karel's position
+#define JOURNAL_SNAPSHOT_EVERY 1024
+
+// most picks and puts kept
+#define JOURNAL_MAX_BEEPER_OPS 4096
+
+/*
+ * 'journal_init'
+ *
+ * Empties the journal.
+ *
+ * @params  Karel's position at step 0
+ * @returns none
+ */
+void journal_init(pos_t start);
+
+/*
+ * 'journal_push'
+ *
+ * Records a move Karel just made (MOVE_FORWARD,
+ * TURN_LEFT, TURN_RIGHT, PICK_BEEPER or PUT_BEEPER,
+ * see accel.h),
+ * throwing away any moves that could have been
+ * redone. Blocked moves must not be recorded.
+ *
+ * @params  move Karel made
+ * @returns 1 if recorded, 0 if the move is not one
+ *          Karel can undo or the journal was full (it
+ *          then starts over from Karel's position)
+ */
+int journal_push(int move);
+
+/*
+ * 'journal_undo'
+ *
+ * Takes back the last move, in constant time.
+ *
+ * @params  none
+ * @returns the move that took it back (MOVE_BACKWARD,
+ *          TURN_RIGHT, PUT_BEEPER or PICK_BEEPER), or
+ *          -1 if at step 0
+ */
+int journal_undo(void);
+
+/*
+ * 'journal_redo'
+ *
+ * Makes the last undone move again.
+ *
+ * @params  none
+ * @returns the move made, or -1 if there is none
+ */
+int journal_redo(void);
+
+/*
+ * 'journal_goto'
+ *
+ * Puts Karel and the beepers back the way they were
+ * after the given number of moves, keeping the later
+ * moves for redo.
+ *
+ * @params  step, from 0 to journal_length()
+ * @returns 1 on success, 0 if step is out of range
+ */
+int journal_goto(int step);
+
+/*
+ * 'journal_step'
+ *
+ * @params  none
+ * @returns number of moves Karel has made, not
+ *          counting undone ones
+ */
+int journal_step(void);
+
+/*
+ * 'journal_length'
+ *
+ * @params  none
+ * @returns number of moves in the journal, including
+ *          ones that can be redone
+ */
+int journal_length(void);
+
+#endif
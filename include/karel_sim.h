@@ -0,0 +1,110 @@
+#ifndef KAREL_SIM_H
+#define KAREL_SIM_H
+
+/*
+ * FILENAME: karel_sim.h
+ * -------------------------------------------------
+ * The headless core of the game engine. It applies
+ * moves to Karel on the board loaded in board.h and
+ * reports what happened, without reading sensors,
+ * drawing or waiting. karel_world.h builds the game
+ * on top of it, and it also runs on a host machine
+ * (`make host`) for testing and benchmarking.
+ *
+ * Karel carries a bag of beepers. He can pick up
+ * beepers from his cell into the bag and put them
+ * down again (see tiles.h for the counts per cell).
+ */
+
+// position and direction of Karel
+typedef struct pos {
+    int x;
+    int y;
+    int dir;
+} pos_t;
+
+// what happened after a move
+enum sim_result {
+    SIM_OK,       // Karel moved or turned
+    SIM_BLOCKED,  // Karel bumped into a wall or edge, or had
+                  // no beeper to pick up or put down
+    SIM_FINISHED, // the goal is reached
+};
+
+// when the game is won
+enum sim_goal {
+    GOAL_REACH_BEEPER, // Karel is on a beeper (the default)
+    GOAL_COLLECT_ALL,  // no beepers are left on the board
+};
+
+/*
+ * 'karel_sim_init'
+ *
+ * Puts Karel at the given position on the loaded board.
+ * His beeper bag is left as it is.
+ *
+ * @params  starting position and direction
+ * @returns none
+ */
+void karel_sim_init(pos_t start);
+
+/*
+ * 'karel_sim_step'
+ *
+ * Applies one move (MOVE_FORWARD, MOVE_BACKWARD,
+ * TURN_LEFT, TURN_RIGHT, PICK_BEEPER or PUT_BEEPER,
+ * see accel.h) to Karel. Moving backward keeps his
+ * direction. Blocked moves leave Karel and the
+ * beepers as they are; other moves are ignored.
+ * Costs O(1), including the check for the goal.
+ *
+ * @params  move to apply
+ * @returns result of the move (enum sim_result)
+ */
+int karel_sim_step(int move);
+
+/*
+ * 'karel_sim_set_goal'
+ *
+ * @params  when the game is won (enum sim_goal)
+ * @returns none
+ */
+void karel_sim_set_goal(int goal);
+
+/*
+ * 'karel_sim_set_bag'
+ *
+ * @params  number of beepers in Karel's bag
+ * @returns none
+ */
+void karel_sim_set_bag(int beepers);
+
+/*
+ * 'karel_sim_bag'
+ *
+ * @params  none
+ * @returns number of beepers in Karel's bag
+ */
+int karel_sim_bag(void);
+
+/*
+ * 'karel_sim_peek'
+ *
+ * Works out where a move would take Karel from the
+ * given position, without moving him.
+ *
+ * @params  position to start from, move to apply
+ * @returns position after the move (unchanged if
+ *          the move is blocked)
+ */
+pos_t karel_sim_peek(pos_t pos, int move);
+
+/*
+ * 'karel_sim_position'
+ *
+ * @params  none
+ * @returns Karel's current position and direction
+ */
+pos_t karel_sim_position(void);
+
+#endif
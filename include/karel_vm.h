@@ -0,0 +1,136 @@
+#ifndef KAREL_VM_H
+#define KAREL_VM_H
+
+/*
+ * FILENAME: karel_vm.h
+ * -------------------------------------------------
+ * A small Karel language, compiled to bytecode and
+ * run against the headless engine (karel_sim.h).
+ * Programs are typed into the shell, e.g.
+ *
+ *     def turn_right { turn_left turn_left turn_left }
+ *     while front_is_clear { move } turn_right
+ *
+ * Statements:
+ *     move  turn_left  pick_beeper  put_beeper  <name>
+ *     repeat N { ... }
+ *     while [not] <predicate> { ... }
+ *     if [not] <predicate> { ... } else { ... }
+ *     def <name> { ... }
+ *
+ * Predicates: front_is_clear, front_is_blocked,
+ * beepers_present, no_beepers_present, facing_east,
+ * facing_north, facing_west, facing_south.
+ *
+ * A trailing "()" after a name and ';' are allowed
+ * and ignored. Functions stay defined for later
+ * programs, so they can be typed one line at a time.
+ */
+
+#include "karel_sim.h"
+
+// bytecode instructions; operands follow as bytes,
+// 16-bit operands are stored low byte first
+enum karel_op {
+    OP_HALT,
+    OP_MOVE,
+    OP_TURN_LEFT,
+    OP_PICK_BEEPER,
+    OP_PUT_BEEPER,
+    OP_JUMP,         // addr16
+    OP_JUMP_IF_NOT,  // cond8 addr16: jump if condition is false
+    OP_JUMP_IF,      // cond8 addr16: jump if condition is true
+    OP_REPEAT,       // count16 addr16: push count, or jump if 0
+    OP_LOOP,         // addr16: decrement count, jump while not 0
+    OP_CALL,         // addr16
+    OP_RETURN,
+    NUM_OPS,
+};
+
+// conditions; COND_NOT inverts any of them
+enum karel_cond {
+    COND_FRONT_CLEAR,
+    COND_BEEPERS_PRESENT,
+    COND_FACING_EAST,
+    COND_FACING_NORTH,
+    COND_FACING_WEST,
+    COND_FACING_SOUTH,
+    COND_NOT = 0x80,
+};
+
+// why a program stopped
+enum karel_vm_status {
+    VM_HALTED,      // program ran to the end
+    VM_FINISHED,    // the goal was reached (see karel_sim.h)
+    VM_BLOCKED,     // Karel hit a wall or had no beeper to use
+    VM_LIMIT,       // ran out of instructions
+    VM_STACK,       // calls or loops nested too deeply
+};
+
+typedef struct karel_vm_result {
+    int status;                // enum karel_vm_status
+    unsigned int instructions; // bytecode instructions executed
+    unsigned int actions;      // moves, turns, picks and puts made
+} karel_vm_result_t;
+
+// largest program, in bytes of bytecode
+#define KAREL_CODE_SIZE 4096
+
+/*
+ * 'karel_compile'
+ *
+ * Compiles a program into the bytecode buffer (see
+ * karel_bytecode). On failure nothing changes and
+ * karel_compile_error describes why.
+ *
+ * @params  program source
+ * @returns address of the program's first instruction,
+ *          or -1 on error
+ */
+int karel_compile(const char *source);
+
+/*
+ * 'karel_bytecode'
+ *
+ * @params  none
+ * @returns the compiled bytecode, including functions
+ *          kept from earlier programs
+ */
+const unsigned char *karel_bytecode(void);
+
+/*
+ * 'karel_compile_error'
+ *
+ * @params  none
+ * @returns message for the last failed compile
+ */
+const char *karel_compile_error(void);
+
+/*
+ * 'karel_compile_size'
+ *
+ * @params  none
+ * @returns bytes of bytecode in use, including
+ *          functions kept from earlier programs
+ */
+int karel_compile_size(void);
+
+/*
+ * 'karel_vm_run'
+ *
+ * Runs bytecode from the given address, moving Karel
+ * from his current position. render is called every
+ * render_every actions (never if 0 or NULL) and once
+ * at the end.
+ *
+ * @params  bytecode, address to start at, most
+ *          instructions to run, render function,
+ *          how often to render
+ * @returns why the program stopped and how much ran
+ */
+karel_vm_result_t karel_vm_run(const unsigned char *code, int entry,
+                               unsigned int max_instructions,
+                               void (*render)(pos_t karel),
+                               unsigned int render_every);
+
+#endif
@@ -4,20 +4,22 @@
 /*
  * FILENAME: karel_world.h
  * -------------------------------------------------
- * Implements the game engine of the game of Karel.
+ * Implements the game engine of the game of Karel,
+ * connecting the headless core (karel_sim.h) to the
+ * player's input (input.h) and the screen.
  */
 
-// position and direction of Karel
-typedef struct pos {
-    int x;
-    int y;
-    int dir;
-} pos_t;
+#include "karel_sim.h"
+#include "script.h"
+
+// time between frames: the screen is redrawn at up to 60 Hz
+#define KAREL_FRAME_US 16667
 
 /*
  * "karel_world_init"
  *
- * Initialises the console display of Karel's world
+ * Initialises the console display of Karel's world,
+ * and takes moves from the sensor and the keyboard
  */
 void karel_world_init(void);
 
@@ -26,11 +28,89 @@ void karel_world_init(void);
  *
  * Updates karel world according to the movements of 
  * the player. Returns true (1) when Karel finds the 
- * beeper and game is over, false otherwise.
+ * beeper and game is over, false otherwise. A
+ * MOVE_BACKWARD takes back the last move (journal.h).
  *
  * @params  none
  * @returns 1 (if game is over), 0 (game not over)
  */
 int update_karel_world(void);
 
+/*
+ * "karel_world_apply"
+ *
+ * Applies one move without waiting or drawing; a
+ * MOVE_BACKWARD takes back the last move. The move
+ * is recorded for replay and undo.
+ *
+ * @params  move (see accel.h)
+ * @returns result of the move (enum sim_result)
+ */
+int karel_world_apply(int move);
+
+/*
+ * "karel_world_draw"
+ *
+ * Draws the next frame if anything changed since
+ * the last one. Moves are animated for a little
+ * less than the pause between moves, so call this
+ * as often as frames should be drawn (every
+ * KAREL_FRAME_US).
+ *
+ * @params  none
+ * @returns 1 if a frame was drawn, 0 otherwise
+ */
+int karel_world_draw(void);
+
+/*
+ * "karel_world_show_hint"
+ *
+ * Follows the shortest path from Karel to the nearest
+ * beeper and redraws the board with its next few cells
+ * highlighted. The hint is cleared when Karel moves.
+ *
+ * @params  none
+ * @returns none
+ */
+void karel_world_show_hint(void);
+
+/*
+ * "karel_world_moves_remaining"
+ *
+ * @params  none
+ * @returns fewest move()/turn_left() actions Karel needs
+ *          to reach a beeper, or -1 if it cannot
+ */
+int karel_world_moves_remaining(void);
+
+/*
+ * "karel_world_run_script"
+ *
+ * Compiles and runs a Karel program from Karel's
+ * current position at full speed, drawing every
+ * render_every steps (0 for only the final state).
+ * Prints how many steps ran and how long it took.
+ *
+ * @params  program and its length, how often to draw
+ * @returns why the program stopped (enum script_status)
+ */
+int karel_world_run_script(script_cmd_t *prog, int len,
+                           unsigned int render_every);
+
+/*
+ * "karel_world_replay"
+ *
+ * Puts the level back the way it started and replays
+ * every move recorded since karel_world_init (see
+ * replay.h), drawing after each one, and prints how
+ * long it took. Karel ends up where the player left
+ * him, unless the recording was too long to keep and
+ * its oldest moves picked or put beepers.
+ *
+ * @params  1 to replay at the pace the moves were
+ *          made, 0 for as fast as possible
+ * @returns none
+ */
+void karel_world_replay(int realtime);
+
 #endif
@@ -0,0 +1,45 @@
+#ifndef KEYS_H
+#define KEYS_H
+
+/*
+ * FILENAME: keys.h
+ * -------------------------------------------------
+ * Reads moves from the arrow keys of a PS/2 keyboard
+ * (see ps2.h), for playing without the sensor: up
+ * steps forward, down takes the last move back, and
+ * left and right turn. Holding a key repeats the
+ * move at the keyboard's typematic rate.
+ *
+ * The keyboard's clock and data lines go to GPIO 20
+ * and 21, since GPIO 3, where assign5 had the clock,
+ * is the sensor's I2C clock.
+ */
+
+#include "input.h"
+
+// plays the moves made on the keyboard
+extern const input_source_t input_keys;
+
+/*
+ * 'keys_init'
+ *
+ * Starts reading the keyboard in the background (it
+ * turns interrupts on).
+ *
+ * @params  none
+ * @returns 1 (a keyboard cannot be detected)
+ */
+int keys_init(void);
+
+/*
+ * 'keys_poll_move'
+ *
+ * Takes the oldest move typed so far, without
+ * waiting. Keys that make no move are skipped.
+ *
+ * @params  none
+ * @returns move being made, or -1 if none
+ */
+int keys_poll_move(void);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef MAZE_H
+#define MAZE_H
+
+/*
+ * FILENAME: maze.h
+ * -------------------------------------------------
+ * Generates random mazes straight into the board
+ * (see board.h). The same seed always gives the same
+ * maze, so a level can be shared as a single number.
+ *
+ * All algorithms are iterative and use static memory
+ * sized for the largest board, so even the biggest
+ * maze fits in our small stack.
+ */
+
+// the algorithms we can generate mazes with
+enum maze_algorithm {
+    MAZE_BACKTRACKER, // long winding corridors
+    MAZE_KRUSKAL,     // many short dead ends
+    MAZE_WILSON,      // uniformly random maze
+};
+
+/*
+ * 'maze_generate'
+ *
+ * Replaces the loaded board with a new maze. Karel
+ * starts in the bottom left corner as usual, and a
+ * beeper is placed in the top right corner.
+ *
+ * Every wall is kept (each cell has a mask of its
+ * four walls, see board_walls), so the maze is a
+ * perfect one: there are no loops, and exactly one
+ * path joins any two cells.
+ *
+ * @params  number of rows and columns, seed (0 picks
+ *          one with rand()), algorithm to use
+ * @returns the seed used
+ * @precon  size must fit in BOARD_MAX_ROWS x BOARD_MAX_COLS
+ */
+unsigned int maze_generate(int nrows, int ncols, unsigned int seed,
+                           enum maze_algorithm algorithm);
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef MOVE_QUEUE_H
+#define MOVE_QUEUE_H
+
+/*
+ * FILENAME: move_queue.h
+ * -------------------------------------------------
+ * A queue of the moves the player made, in the order
+ * they were recognised. Like the ring buffer behind
+ * the PS/2 driver (ringbuffer.h), it has one writer,
+ * which may be an interrupt handler, and one reader,
+ * the main program, and needs no locking between
+ * them. Unlike rb_t it is a single static queue, so
+ * nothing is allocated.
+ */
+
+// most moves waiting at once (a power of two)
+#define MOVE_QUEUE_SIZE 16
+
+/*
+ * 'move_queue_push'
+ *
+ * Adds a move at the back of the queue. Only one
+ * context may push.
+ *
+ * @params  the move (enum moves in accel.h)
+ * @returns 1 if added, 0 if the queue was full and
+ *          the move was dropped
+ */
+int move_queue_push(int move);
+
+/*
+ * 'move_queue_pop'
+ *
+ * Takes the move at the front of the queue, without
+ * waiting. Only one context may pop.
+ *
+ * @params  none
+ * @returns the move, or -1 if the queue is empty
+ */
+int move_queue_pop(void);
+
+/*
+ * 'move_queue_count'
+ *
+ * @params  none
+ * @returns number of moves waiting
+ */
+int move_queue_count(void);
+
+/*
+ * 'move_queue_dropped'
+ *
+ * @params  none
+ * @returns number of moves dropped because the queue
+ *          was full
+ */
+int move_queue_dropped(void);
+
+/*
+ * 'move_queue_clear'
+ *
+ * Drops every move waiting, e.g. ones made before a
+ * game started. Like move_queue_pop, only the reader
+ * may call it.
+ *
+ * @params  none
+ * @returns none
+ */
+void move_queue_clear(void);
+
+#endif
@@ -66,6 +66,18 @@ ps2_device_t *ps2_new(unsigned int clock_gpio, unsigned int data_gpio);
 unsigned char ps2_read(ps2_device_t *dev);
 
 
+/*
+ * `ps2_has_scancode`
+ *
+ * Returns whether a scancode has been received and not yet read,
+ * so a client that cannot wait can check before calling `ps2_read`.
+ *
+ * @param dev     PS2 device to check
+ * @return        true if `ps2_read` would return without waiting
+ */
+bool ps2_has_scancode(ps2_device_t *dev);
+
+
 /*
  * `ps2_write`: optional extension
  *
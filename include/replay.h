@@ -0,0 +1,107 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+/*
+ * FILENAME: replay.h
+ * -------------------------------------------------
+ * Records every move the player makes, with the time
+ * since the previous one, so a session can be dumped
+ * over UART and replayed through the headless engine
+ * (karel_sim.h) move for move, either at the pace it
+ * was played or as fast as possible.
+ *
+ * Each move takes one byte, plus one more for every
+ * 7 bits of its delay past 15 ms, in a ring buffer.
+ * When the ring is full the oldest moves are dropped
+ * and the replay starts after them.
+ */
+
+#include "karel_sim.h"
+
+// bytes of recorded moves kept
+#define REPLAY_BUFFER_SIZE 4096
+
+// result of a replay
+typedef struct replay_result {
+    int status;         // result of the last move (enum sim_result)
+    unsigned int moves; // moves replayed
+} replay_result_t;
+
+/*
+ * 'replay_record_start'
+ *
+ * Throws away the recording and starts a new one.
+ *
+ * @params  Karel's starting position, current time in
+ *          microseconds (e.g. timer_get_ticks)
+ * @returns none
+ */
+void replay_record_start(pos_t start, unsigned int now_us);
+
+/*
+ * 'replay_record'
+ *
+ * Adds a move to the recording.
+ *
+ * @params  move (see accel.h), current time in
+ *          microseconds
+ * @returns none
+ */
+void replay_record(int move, unsigned int now_us);
+
+/*
+ * 'replay_num_moves'
+ *
+ * @params  none
+ * @returns number of moves in the recording
+ */
+int replay_num_moves(void);
+
+/*
+ * 'replay_size'
+ *
+ * @params  none
+ * @returns bytes used by the recording
+ */
+int replay_size(void);
+
+/*
+ * 'replay_dump'
+ *
+ * Prints the recording as hex bytes, which can be
+ * passed back to replay_load.
+ *
+ * @params  none
+ * @returns none
+ */
+void replay_dump(void);
+
+/*
+ * 'replay_load'
+ *
+ * Replaces the recording with encoded moves, as
+ * printed by replay_dump.
+ *
+ * @params  Karel's starting position, encoded moves
+ *          and their length in bytes
+ * @returns number of moves, or -1 if the data is cut
+ *          short or too long
+ */
+int replay_load(pos_t start, const unsigned char *data, int len);
+
+/*
+ * 'replay_run'
+ *
+ * Puts Karel back at the start of the recording and
+ * replays every move. wait_ms is called before each
+ * move with its recorded delay (NULL replays as fast
+ * as possible) and render after each move (NULL to
+ * skip drawing). The recording is left unchanged.
+ *
+ * @params  wait function, render function
+ * @returns result of the last move and number of moves
+ */
+replay_result_t replay_run(void (*wait_ms)(unsigned int ms),
+                           void (*render)(pos_t karel));
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+/*
+ * FILENAME: sched.h
+ * -------------------------------------------------
+ * Runs callbacks at given times and sleeps until a
+ * deadline instead of spinning on the timer. Callbacks
+ * run from sched_run and the sleeps, never from an
+ * interrupt, so they may draw or read the sensor.
+ *
+ * The scheduler reads the time through a clock given
+ * to sched_init: the system timer on the Pi (see
+ * timer_idle in timer.h), or a simulated clock that
+ * jumps straight to each deadline, for the host and
+ * for tests.
+ */
+
+// most callbacks waiting at once
+#define SCHED_MAX_EVENTS 16
+
+// a callback, given the pointer passed to sched_add
+typedef void (*sched_fn_t)(void *aux);
+
+/*
+ * 'sched_init'
+ *
+ * Cancels every callback and sets the clock to use.
+ *
+ * @params  function returning the time in microseconds,
+ *          function waiting until the given time or an
+ *          interrupt (it may return early); pass 0 for
+ *          both to use the simulated clock
+ * @returns none
+ */
+void sched_init(unsigned int (*now_us)(void), void (*idle)(unsigned int until_us));
+
+/*
+ * 'sched_add'
+ *
+ * Schedules a callback. Times may wrap around; a
+ * time up to 2^31 us in the past counts as due.
+ *
+ * @params  time to run it in microseconds, period in
+ *          microseconds to run it again (0 to run it
+ *          once), callback and its argument
+ * @returns id for sched_cancel, or -1 if
+ *          SCHED_MAX_EVENTS callbacks are waiting
+ */
+int sched_add(unsigned int when_us, unsigned int period_us, sched_fn_t fn, void *aux);
+
+/*
+ * 'sched_cancel'
+ *
+ * @params  id returned by sched_add; ids of callbacks
+ *          that already ran once are ignored
+ * @returns none
+ */
+void sched_cancel(int id);
+
+/*
+ * 'sched_run'
+ *
+ * Runs the callbacks that are due, earliest first.
+ * A periodic callback that fell more than a period
+ * behind skips the periods it missed.
+ *
+ * @params  none
+ * @returns number of callbacks run
+ */
+int sched_run(void);
+
+/*
+ * 'sched_sleep_until'
+ *
+ * Waits until the given time, idling the clock and
+ * running callbacks as they come due.
+ *
+ * @params  time in microseconds
+ * @returns none
+ */
+void sched_sleep_until(unsigned int when_us);
+
+/*
+ * 'sched_sleep_ms'
+ *
+ * Like sched_sleep_until, for the given number of
+ * milliseconds from now.
+ *
+ * @params  milliseconds
+ * @returns none
+ */
+void sched_sleep_ms(unsigned int ms);
+
+/*
+ * 'sched_now'
+ *
+ * @params  none
+ * @returns time of the clock in microseconds
+ */
+unsigned int sched_now(void);
+
+/*
+ * 'sched_sim_set'
+ *
+ * Sets the simulated clock, e.g. just before it
+ * wraps around.
+ *
+ * @params  time in microseconds
+ * @returns none
+ */
+void sched_sim_set(unsigned int now_us);
+
+#endif
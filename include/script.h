@@ -0,0 +1,86 @@
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+/*
+ * FILENAME: script.h
+ * -------------------------------------------------
+ * Runs Karel programs, i.e. sequences of move() and
+ * turn_left() with repeat loops and while loops on
+ * what Karel can sense, against the headless engine
+ * (karel_sim.h). Student solutions replay at full
+ * speed, drawing only every Nth step if at all.
+ *
+ * A program is an array of script_cmd_t. Each REPEAT
+ * and WHILE is closed by an END; script_compile links
+ * them up before the program runs.
+ */
+
+#include "karel_sim.h"
+
+enum script_op {
+    SCRIPT_MOVE,      // move()
+    SCRIPT_TURN_LEFT, // turn_left()
+    SCRIPT_REPEAT,    // repeat arg times ... END
+    SCRIPT_WHILE,     // while condition arg holds ... END
+    SCRIPT_END,
+};
+
+// conditions for SCRIPT_WHILE
+enum script_cond {
+    COND_FRONT_IS_CLEAR,
+    COND_FRONT_IS_BLOCKED,
+    COND_ON_BEEPER,
+    COND_NOT_ON_BEEPER,
+};
+
+typedef struct script_cmd {
+    unsigned char op;    // enum script_op
+    unsigned short arg;  // repeat count or condition
+    unsigned short jump; // filled in by script_compile
+} script_cmd_t;
+
+// why a program stopped
+enum script_status {
+    SCRIPT_DONE,     // ran off the end of the program
+    SCRIPT_FINISHED, // Karel reached a beeper
+    SCRIPT_BLOCKED,  // Karel tried to move into a wall
+    SCRIPT_LIMIT,    // ran too many commands (e.g. endless loop)
+};
+
+typedef struct script_result {
+    int status;          // enum script_status
+    unsigned int steps;  // move() and turn_left() executed
+} script_result_t;
+
+// called with Karel's position to draw a frame
+typedef void (*script_render_fn_t)(pos_t karel);
+
+/*
+ * 'script_compile'
+ *
+ * Matches every REPEAT and WHILE with its END.
+ *
+ * @params  program and its length
+ * @returns 0 on success, -1 if loops are unbalanced or
+ *          nested too deeply
+ */
+int script_compile(script_cmd_t *prog, int len);
+
+/*
+ * 'script_run'
+ *
+ * Runs a compiled program from Karel's current
+ * position. If render is not NULL, it is called every
+ * render_every steps (never if 0) and once at the end.
+ *
+ * @params  program and its length, most commands to run
+ *          (including loop checks), render function,
+ *          how often to render
+ * @returns why the program stopped and how many steps ran
+ */
+script_result_t script_run(const script_cmd_t *prog, int len,
+                           unsigned int max_cmds,
+                           script_render_fn_t render,
+                           unsigned int render_every);
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef SENSOR_FIFO_H
+#define SENSOR_FIFO_H
+
+/*
+ * FILENAME: sensor_fifo.h
+ * -------------------------------------------------
+ * Streams samples from the LSM6DS33's own FIFO, which
+ * collects gyroscope and accelerometer readings at a
+ * fixed rate while the processor does something else.
+ * Each drain reads every complete sample the chip has
+ * stored in a few long I2C reads and keeps them in a
+ * ring buffer until they are popped. Drains can run
+ * in the background from the I2C interrupt, so the
+ * game loop never waits on the bus.
+ *
+ * Only the register functions of LSM6DS33.h are used,
+ * so on the host the module runs against a simulated
+ * chip (see src/host/lsm6ds33-sim.c).
+ */
+
+// rates the chip can fill its FIFO at (ODR_FIFO in FIFO_CTRL5)
+enum sensor_fifo_rate {
+    FIFO_RATE_104HZ = 4,
+    FIFO_RATE_208HZ,
+    FIFO_RATE_416HZ,
+    FIFO_RATE_833HZ,
+    FIFO_RATE_1660HZ,
+};
+
+// one reading of both sensors, x, y and z
+typedef struct sensor_sample {
+    short gyro[3];
+    short accel[3];
+} sensor_sample_t;
+
+// samples kept between drains and pops (a power of two)
+#define SENSOR_RING_SIZE 256
+
+/*
+ * 'sensor_fifo_start'
+ *
+ * Empties the chip's FIFO and the ring and has the
+ * chip store both sensors, undecimated, at the given
+ * rate, overwriting the oldest samples when full.
+ *
+ * @params  rate (enum sensor_fifo_rate), samples at
+ *          which the chip reports its watermark
+ * @returns none
+ * @precon  lsm6ds33_init has been called
+ */
+void sensor_fifo_start(int rate, int watermark);
+
+/*
+ * 'sensor_fifo_stop'
+ *
+ * Stops the chip's FIFO. Samples in the ring can
+ * still be popped.
+ *
+ * @params  none
+ * @returns none
+ */
+void sensor_fifo_stop(void);
+
+/*
+ * 'sensor_fifo_drain'
+ *
+ * Moves the complete samples stored in the chip into
+ * the ring, as many as fit, and waits until they are
+ * in. Half a sample left over from an earlier read is
+ * skipped.
+ *
+ * @params  none
+ * @returns number of samples moved
+ */
+int sensor_fifo_drain(void);
+
+/*
+ * 'sensor_fifo_drain_start'
+ *
+ * Starts a drain like sensor_fifo_drain without
+ * waiting for it. Once i2c_interrupts_enable has been
+ * called the samples arrive in the ring in the
+ * background; until then the drain is done before
+ * this returns.
+ *
+ * @params  none
+ * @returns 1 if a drain was started, 0 if one is
+ *          still running or the I2C queue is full
+ */
+int sensor_fifo_drain_start(void);
+
+// called when a drain is over, see sensor_fifo_set_drain_handler
+typedef void (*sensor_drain_fn_t)(void);
+
+/*
+ * 'sensor_fifo_set_drain_handler'
+ *
+ * Sets a function to call each time a drain is over,
+ * e.g. to pop the new samples. With interrupts on it
+ * is called from the I2C interrupt, so it must be
+ * short; it may pop samples but must not start a
+ * blocking drain.
+ *
+ * @params  the function, or 0 for none
+ * @returns none
+ */
+void sensor_fifo_set_drain_handler(sensor_drain_fn_t fn);
+
+/*
+ * 'sensor_fifo_draining'
+ *
+ * @params  none
+ * @returns 1 while a drain is running, 0 otherwise
+ */
+int sensor_fifo_draining(void);
+
+/*
+ * 'sensor_fifo_pop'
+ *
+ * Takes the oldest sample out of the ring.
+ *
+ * @params  where to put the sample
+ * @returns 1 if there was one, 0 if the ring is empty
+ */
+int sensor_fifo_pop(sensor_sample_t *sample);
+
+/*
+ * 'sensor_fifo_available'
+ *
+ * @params  none
+ * @returns number of samples in the ring
+ */
+int sensor_fifo_available(void);
+
+/*
+ * 'sensor_fifo_overruns'
+ *
+ * @params  none
+ * @returns number of drains that found the chip's
+ *          FIFO had overflowed and lost samples
+ *          since sensor_fifo_start
+ */
+int sensor_fifo_overruns(void);
+
+#endif
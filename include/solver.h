@@ -0,0 +1,53 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+/*
+ * FILENAME: solver.h
+ * -------------------------------------------------
+ * Finds shortest paths through the board currently
+ * loaded by board_init, using Karel's own actions:
+ * move() and turn_left(). Turning right costs three
+ * left turns, so the cheapest route is not always
+ * the one with the fewest cells.
+ *
+ * Paths are found with A*, using the Manhattan
+ * distance plus the fewest left turns needed to
+ * face the goal as the heuristic.
+ */
+
+#include "karel_sim.h"
+
+// statistics about the last search
+typedef struct solver_stats {
+    unsigned int expanded; // states taken off the open list
+    unsigned int pushed;   // states put on the open list
+} solver_stats_t;
+
+/*
+ * 'solver_find_path'
+ *
+ * Finds the shortest sequence of MOVE_FORWARD and
+ * TURN_LEFT actions (see accel.h) taking Karel from
+ * start to the goal cell, facing any direction.
+ *
+ * At most max_len actions are written to path, so a
+ * hint only needs a small buffer; the returned length
+ * is always the full length of the path.
+ *
+ * @params  start position and direction, goal cell,
+ *          buffer for actions and its size
+ * @returns number of actions, or -1 if unreachable
+ */
+int solver_find_path(pos_t start, int goal_x, int goal_y,
+                     unsigned char *path, int max_len);
+
+/*
+ * 'solver_get_stats'
+ *
+ * @params  none
+ * @returns statistics about the last call to
+ *          solver_find_path
+ */
+solver_stats_t solver_get_stats(void);
+
+#endif
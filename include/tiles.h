@@ -0,0 +1,119 @@
+#ifndef TILES_H
+#define TILES_H
+
+/*
+ * FILENAME: tiles.h
+ * -------------------------------------------------
+ * Keeps an index of the special tiles on the board
+ * (beepers, Pat and Julie). The index is built once
+ * when a board is loaded, so the game never has to
+ * scan the whole board again to find them.
+ *
+ * Every BEEPER tile starts with one beeper. After
+ * that the index keeps the number of beepers in each
+ * cell, which Karel can pick up and put down.
+ */
+
+// position of a tile on the board
+typedef struct tile_pos {
+    short x;
+    short y;
+} tile_pos_t;
+
+/*
+ * 'tiles_build'
+ *
+ * Scans the given board once and records the position
+ * of every BEEPER, PAT and JULIE tile. Any previous
+ * index is discarded.
+ *
+ * @params  board, number of rows and columns in board
+ * @returns none
+ * @precon  board must fit in BOARD_MAX_ROWS x BOARD_MAX_COLS
+ */
+void tiles_build(const char *board[], int nrows, int ncols);
+
+/*
+ * 'tiles_update'
+ *
+ * Updates the index after one tile changed. Costs
+ * O(k) in the number of tiles of the old kind, or
+ * O(1) for beepers. A new BEEPER tile holds one
+ * beeper; replacing a BEEPER tile removes them all.
+ *
+ * @params  x and y position, old and new tile
+ * @returns none
+ */
+void tiles_update(int x, int y, int old_tile, int new_tile);
+
+/*
+ * 'tiles_has_beeper'
+ *
+ * Checks in constant time whether there is a beeper
+ * at (x, y).
+ *
+ * @params  x and y position on the board
+ * @returns 1 if there is a beeper, 0 otherwise
+ */
+int tiles_has_beeper(int x, int y);
+
+/*
+ * 'tiles_beepers'
+ *
+ * @params  x and y position on the board
+ * @returns number of beepers at (x, y)
+ */
+int tiles_beepers(int x, int y);
+
+/*
+ * 'tiles_total_beepers'
+ *
+ * @params  none
+ * @returns number of beepers on the whole board,
+ *          kept up to date in O(1)
+ */
+int tiles_total_beepers(void);
+
+/*
+ * 'tiles_add_beeper'
+ *
+ * Puts one more beeper at (x, y), in constant time.
+ *
+ * @params  x and y position on the board
+ * @returns 1 if added, 0 if the cell is full or too
+ *          many cells have beepers
+ */
+int tiles_add_beeper(int x, int y);
+
+/*
+ * 'tiles_remove_beeper'
+ *
+ * Takes one beeper from (x, y), in constant time.
+ *
+ * @params  x and y position on the board
+ * @returns 1 if removed, 0 if there was none
+ */
+int tiles_remove_beeper(int x, int y);
+
+/*
+ * 'tiles_count'
+ *
+ * @params  kind of tile (BEEPER, PAT or JULIE)
+ * @returns number of tiles of that kind on the board
+ *          (for BEEPER, the number of cells with beepers)
+ */
+int tiles_count(int kind);
+
+/*
+ * 'tiles_list'
+ *
+ * Returns the positions of all tiles of the given kind,
+ * so they can be enumerated in O(k). The array has
+ * tiles_count(kind) entries.
+ *
+ * @params  kind of tile (BEEPER, PAT or JULIE)
+ * @returns array of positions, or NULL for other kinds
+ */
+const tile_pos_t *tiles_list(int kind);
+
+#endif
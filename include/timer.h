@@ -15,12 +15,33 @@
 /*
  * `timer_init`
  *
- * Initialize the timer. For assignment 2, this does nothing.
- * However, all libpi peripheral modules require an init, so it is
- * included for consistency's sake.
+ * Initialize the timer. Sets up the interrupts module and an
+ * armtimer interrupt every TIMER_WAKE_US microseconds, which wakes
+ * the processor from `timer_idle`, enables interrupts and starts the
+ * cycle counter. Calling it again does nothing. No other module may
+ * call `interrupts_init`.
  */
 void timer_init(void);
 
+// period of the interrupt that wakes `timer_idle`
+#define TIMER_WAKE_US 1000
+
+// called from that interrupt with the pc it interrupted
+typedef void (*timer_tick_fn_t)(unsigned int pc);
+
+/*
+ * `timer_set_tick_handler`
+ *
+ * Has the wake interrupt also call `fn` every TIMER_WAKE_US, e.g. to
+ * sample the pc for a profiler. The interrupt belongs to `timer_idle`,
+ * so this is the only way to share it: no other module may set up or
+ * stop the armtimer.
+ *
+ * @param fn  the function, or NULL to stop calling one
+ * @precon    `timer_init` has been called
+ */
+void timer_set_tick_handler(timer_tick_fn_t fn);
+
 /*
  * `timer_get_ticks`
  *
@@ -32,6 +53,46 @@ void timer_init(void);
  */
 unsigned int timer_get_ticks(void);
 
+/*
+ * `timer_get_ticks64`
+ *
+ * Returns the system tick count as 64 bits, combining the high and
+ * low halves of the system timer so that a carry between the two
+ * reads is never missed. Unlike `timer_get_ticks`, it does not wrap
+ * around after 71 minutes, so use it to time anything that may run
+ * that long.
+ *
+ * @return  system tick count
+ */
+unsigned long long timer_get_ticks64(void);
+
+// processor clock in MHz, the rate of `timer_get_cycles`
+#define TIMER_CYCLES_PER_US 700
+
+/*
+ * `timer_get_cycles`
+ *
+ * Returns the processor's cycle counter, started by `timer_init`.
+ * It wraps around about every 6 seconds and stops while the
+ * processor sleeps in `timer_idle`, so it is for profiling short
+ * stretches of code to a fraction of a microsecond.
+ *
+ * @return  cycle count
+ */
+unsigned int timer_get_cycles(void);
+
+/*
+ * `timer_idle`
+ *
+ * Sleeps the processor until the next interrupt if `until_us` is
+ * more than TIMER_WAKE_US away, and returns at once otherwise, so
+ * callers loop on it until their deadline (see sched.h). Before
+ * `timer_init`, it always returns at once.
+ *
+ * @param until_us  tick count the caller is waiting for
+ */
+void timer_idle(unsigned int until_us);
+
 /*
  * `timer_delay_us`
  *
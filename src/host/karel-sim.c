@@ -0,0 +1,660 @@
+/*
+ * FILENAME: karel-sim.c
+ * ------------------------------------------------
+ * Host program for the headless engine (`make host`).
+ * It checks generated levels and solver output, and
+ * measures how fast the engine replays moves, all
+ * without a Pi attached.
+ *
+ * Usage: build/host/karel-sim [number of moves]
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+
+#include "board.h"
+#include "accel.h"
+#include "karel_sim.h"
+#include "maze.h"
+#include "solver.h"
+#include "distfield.h"
+#include "script.h"
+#include "karel_vm.h"
+#include "replay.h"
+#include "journal.h"
+#include "tiles.h"
+#include "LSM6DS33.h"
+#include "sensor_fifo.h"
+#include "i2c.h"
+#include "lsm6ds33-sim.h"
+#include "gesture.h"
+#include "fixed.h"
+#include "calibration.h"
+#include "move_queue.h"
+#include "input.h"
+
+#define MAX_PATH (BOARD_MAX_ROWS * BOARD_MAX_COLS * 4)
+
+static unsigned char path[MAX_PATH];
+static unsigned char moves[1 << 20];
+static pos_t history[JOURNAL_MAX_STEPS + 1];
+static int bag_history[JOURNAL_MAX_STEPS + 1];
+static int total_history[JOURNAL_MAX_STEPS + 1];
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Generates a maze and checks that the solver's path
+ * takes Karel to the beeper, and that it is as short
+ * as the distance field says it should be.
+ *
+ * Returns 1 if the level is fine, 0 otherwise.
+ */
+static int validate_level(int dim, unsigned int seed, int algorithm) {
+    maze_generate(dim, dim, seed, algorithm);
+    distfield_compute();
+
+    pos_t start = {0, dim - 1, EAST};
+    int len = solver_find_path(start, dim - 1, 0, path, MAX_PATH);
+    if (len < 0 || len != distfield_get(start)) {
+        printf("level %dx%d seed %u algorithm %d: solver %d, field %d\n",
+               dim, dim, seed, algorithm, len, distfield_get(start));
+        return 0;
+    }
+
+    karel_sim_init(start);
+    int result = len == 0 ? SIM_FINISHED : SIM_OK;
+    for (int i = 0; i < len; i++) {
+        result = karel_sim_step(path[i]);
+        if (result == SIM_BLOCKED || (result == SIM_FINISHED && i < len - 1)) {
+            printf("level %dx%d seed %u algorithm %d: bad step %d of %d\n",
+                   dim, dim, seed, algorithm, i, len);
+            return 0;
+        }
+    }
+    return result == SIM_FINISHED;
+}
+
+// follows the right-hand wall until Karel finds the beeper
+static script_cmd_t right_hand[] = {
+    {SCRIPT_WHILE, COND_NOT_ON_BEEPER},
+        {SCRIPT_REPEAT, 3}, {SCRIPT_TURN_LEFT}, {SCRIPT_END},
+        {SCRIPT_WHILE, COND_FRONT_IS_BLOCKED}, {SCRIPT_TURN_LEFT}, {SCRIPT_END},
+        {SCRIPT_MOVE},
+    {SCRIPT_END},
+};
+
+// a recorded session of sensor samples, with the gestures made in it
+#define TRACE_RATE 104
+#define TRACE_SAMPLES (TRACE_RATE * 600)
+#define TRACE_MAX_GESTURES 512
+#define REST_Z 16393  // 1 g
+#define NOISE 250     // in counts, about 2 dps and 15 mg
+
+#define DEGREES_PER_RADIAN 57.29577951308232
+
+static sensor_sample_t trace[TRACE_SAMPLES];
+static struct {
+    int start, end, move;
+} gestures[TRACE_MAX_GESTURES];
+
+static int noise(void) {
+    return rand() % (2 * NOISE + 1) - NOISE;
+}
+
+/*
+ * Makes up ten minutes of a player holding the board:
+ * noise at rest, forward tilts and quarter turns every
+ * few seconds, and in between knocks (one wild sample)
+ * and jiggles (a quick shake back and forth), which
+ * are not moves. Returns the number of gestures.
+ */
+static int make_trace(int *disturbances) {
+    int count = 0;
+    *disturbances = 0;
+    for (int i = 0; i < TRACE_SAMPLES; i++) {
+        trace[i] = (sensor_sample_t) {{noise(), noise(), noise()},
+                                      {noise(), noise(), REST_Z + noise()}};
+    }
+
+    // a turn's speed ramps up and down over ramp samples and adds up to 90 degrees
+    const int ramp = 8, turn_len = 62;
+    const int peak = 90 * 800 / 7 * TRACE_RATE / (turn_len - ramp);
+
+    // a tilt leans the board forward to tilt_degrees over tilt_ramp samples,
+    // holds it, and leans back: gravity swings from z toward -x while the
+    // gyroscope's y axis reads the rate (240 dps, near the top of its range)
+    const int tilt_ramp = 26, tilt_hold = 8, tilt_degrees = 60;
+    const int tilt_len = 2 * tilt_ramp + tilt_hold;
+    const int tilt_rate = tilt_degrees * 800 / 7 * TRACE_RATE / tilt_ramp;
+
+    for (int at = TRACE_RATE; at < TRACE_SAMPLES - 4 * TRACE_RATE
+            && count < TRACE_MAX_GESTURES; ) {
+        int move = rand() % 2 ? TURN_LEFT : MOVE_FORWARD;
+        int len = move == TURN_LEFT ? turn_len : tilt_len;
+        for (int i = 0; i < len; i++) {
+            sensor_sample_t *sample = &trace[at + i];
+            if (move == TURN_LEFT) {
+                int edge = i < ramp ? i : len - 1 - i < ramp ? len - 1 - i : ramp;
+                sample->gyro[2] += peak * edge / ramp;
+            } else {
+                int leaning = i < tilt_ramp ? 1 : i >= len - tilt_ramp ? -1 : 0;
+                int edge = i < tilt_ramp ? i : i >= len - tilt_ramp ? len - i : tilt_ramp;
+                double angle = tilt_degrees * (double) edge / tilt_ramp / DEGREES_PER_RADIAN;
+                sample->gyro[1] += leaning * tilt_rate;
+                sample->accel[0] = -REST_Z * sin(angle) + noise();
+                sample->accel[2] = REST_Z * cos(angle) + noise();
+            }
+        }
+        gestures[count].start = at;
+        gestures[count].end = at + len;
+        gestures[count].move = move;
+        count++;
+
+        // a knock or a jiggle halfway to the next gesture
+        int gap = 2 * TRACE_RATE + rand() % (2 * TRACE_RATE);
+        int d = at + len + gap / 2;
+        if (rand() % 2) {
+            trace[d].gyro[2] = 20000;
+            trace[d].accel[2] = 8000;
+        } else {
+            for (int i = 0; i < 20; i++) {
+                trace[d + i].gyro[2] = (i / 5 % 2 ? -18000 : 18000) + noise();
+            }
+        }
+        (*disturbances)++;
+        at += len + gap;
+    }
+    return count;
+}
+
+// what the old detector saw in one sample: fixed thresholds, no filtering
+static int raw_move(const sensor_sample_t *sample) {
+    if (sample->gyro[2] / 16 > 1000) return TURN_LEFT;
+    if (sample->accel[2] / 16 < 600) return MOVE_FORWARD;
+    return -1;
+}
+
+/*
+ * Runs the trace through a detector and matches its
+ * moves to the gestures. A gesture counts as found
+ * by the first move of its kind between its start
+ * and a little after its end; every other move is a
+ * false one. The raw detector is held off for the
+ * game's 250 ms between moves, as it was in play.
+ * The recogniser is given cal, unless it is 0.
+ */
+static void score_trace(int ngestures, int use_raw, const calibration_t *cal,
+                        int *found, int *false_moves, int latency_ms[2]) {
+    int latency_total[2] = {0, 0}, latency_count[2] = {0, 0};
+    int g = 0, cooldown = 0, matched = 0;
+    *found = *false_moves = 0;
+
+    gesture_init(TRACE_RATE);
+    if (cal) {
+        gesture_calibrate(cal);
+    }
+    for (int i = 0; i < TRACE_SAMPLES; i++) {
+        int move;
+        if (use_raw) {
+            move = cooldown > 0 ? -1 : raw_move(&trace[i]);
+            if (cooldown > 0) cooldown--;
+            if (move >= 0) cooldown = TRACE_RATE / 4;
+        } else {
+            move = gesture_feed(&trace[i]);
+        }
+        while (g < ngestures && i > gestures[g].end + TRACE_RATE / 4) {
+            g++;
+            matched = 0;
+        }
+        if (move < 0) continue;
+
+        if (g < ngestures && i >= gestures[g].start && move == gestures[g].move && !matched) {
+            int kind = move == TURN_LEFT;
+            latency_total[kind] += (i - gestures[g].start) * 1000 / TRACE_RATE;
+            latency_count[kind]++;
+            (*found)++;
+            matched = 1;
+        } else {
+            (*false_moves)++;
+        }
+    }
+    for (int kind = 0; kind < 2; kind++) {
+        latency_ms[kind] = latency_count[kind] ? latency_total[kind] / latency_count[kind] : 0;
+    }
+}
+
+static double to_double(fixed_t f) {
+    return f / (double) FIXED_ONE;
+}
+
+// a random number in Q16.16 between -limit and limit
+static fixed_t random_fixed(int limit) {
+    long long range = 2LL * limit * FIXED_ONE;
+    return (fixed_t) ((((long long) rand() << 31 | rand()) % range) - range / 2);
+}
+
+// keeps the benchmark loops from being optimised away
+static volatile fixed_t fixed_sink;
+
+// a function timing n calls of op over inputs a and b, in millions per second
+#define DEFINE_BENCH(name, op)                                      \
+    static double name(const fixed_t *a, const fixed_t *b, int n) { \
+        double start = now_seconds();                               \
+        fixed_t acc = 0;                                            \
+        for (int i = 0; i < n; i++) {                               \
+            acc += op(a[i & 1023], b[i & 1023]);                    \
+        }                                                           \
+        fixed_sink = acc;                                           \
+        return n / (now_seconds() - start) / 1e6;                   \
+    }
+
+static fixed_t sqrt_op(fixed_t a, fixed_t b) {
+    return fixed_sqrt(a);
+}
+
+DEFINE_BENCH(bench_mul, fixed_mul)
+DEFINE_BENCH(bench_div, fixed_div)
+DEFINE_BENCH(bench_add_sat, fixed_add_sat)
+DEFINE_BENCH(bench_sqrt, sqrt_op)
+DEFINE_BENCH(bench_atan2, fixed_atan2)
+
+// as accel.c does from the I2C interrupt: samples of a drain to queued moves
+static void recognise(void) {
+    sensor_sample_t sample;
+    while (sensor_fifo_pop(&sample)) {
+        int move = gesture_feed(&sample);
+        if (move >= 0) {
+            move_queue_push(move);
+        }
+    }
+}
+
+// the moves the simulated chip queues, as a source of input
+static const input_source_t queued_moves = {"sensor", 0, move_queue_pop, move_queue_clear};
+
+/*
+ * Plays a level from its start to the beeper with
+ * the moves the sources give, as the game loop takes
+ * them. Returns the number of moves made, or -1 if a
+ * move was blocked or the moves ran out first.
+ */
+static int play_level(pos_t start) {
+    karel_sim_init(start);
+    for (int moves_made = 1; ; moves_made++) {
+        int move = input_poll();
+        int result = move < 0 ? SIM_BLOCKED : karel_sim_step(move);
+        if (result == SIM_FINISHED) {
+            return moves_made;
+        } else if (result == SIM_BLOCKED) {
+            return -1;
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    long total_moves = argc > 1 ? atol(argv[1]) : 50000000;
+    int failures = 0, levels = 0;
+
+    // 1. validate generated levels and solver output
+    for (int algorithm = MAZE_BACKTRACKER; algorithm <= MAZE_WILSON; algorithm++) {
+        for (int dim = 4; dim <= BOARD_MAX_ROWS; dim *= 2) {
+            for (unsigned int seed = 1; seed <= 8; seed++) {
+                failures += !validate_level(dim, seed, algorithm);
+                levels++;
+            }
+        }
+    }
+    printf("validated %d levels, %d failed\n", levels, failures);
+
+    // 2. replay random moves on the largest maze
+    maze_generate(BOARD_MAX_ROWS, BOARD_MAX_COLS, 107, MAZE_BACKTRACKER);
+    srand(107);
+    for (int i = 0; i < (int) sizeof(moves); i++) {
+        moves[i] = (rand() % 3) ? MOVE_FORWARD : TURN_LEFT;
+    }
+
+    karel_sim_init((pos_t) {0, BOARD_MAX_ROWS - 1, EAST});
+    long finished = 0;
+    double start = now_seconds();
+    for (long i = 0; i < total_moves; i++) {
+        finished += karel_sim_step(moves[i & (sizeof(moves) - 1)]) == SIM_FINISHED;
+    }
+    double elapsed = now_seconds() - start;
+
+    pos_t karel = karel_sim_position();
+    printf("replayed %ld moves in %.3f s (%.1f million moves/s), "
+           "ended at (%d, %d), %ld on beeper\n", total_moves, elapsed,
+           total_moves / elapsed / 1e6, karel.x, karel.y, finished);
+
+    // 3. run a student-style program on every maze size
+    int len = sizeof(right_hand) / sizeof(right_hand[0]);
+    if (script_compile(right_hand, len) < 0) {
+        printf("script: compile failed\n");
+        failures++;
+    }
+    for (int dim = 8; dim <= BOARD_MAX_ROWS; dim *= 2) {
+        maze_generate(dim, dim, 107, MAZE_WILSON);
+        karel_sim_init((pos_t) {0, dim - 1, EAST});
+
+        start = now_seconds();
+        script_result_t result = script_run(right_hand, len, 1u << 30, NULL, 0);
+        elapsed = now_seconds() - start;
+
+        printf("script: %dx%d maze, status %d after %u steps in %.3f ms\n",
+               dim, dim, result.status, result.steps, elapsed * 1e3);
+        failures += result.status != SCRIPT_FINISHED;
+    }
+
+    // 4. the same program in the Karel language, on the bytecode VM
+    if (karel_compile("def turn_right { turn_left turn_left turn_left }") < 0) {
+        printf("karel: %s\n", karel_compile_error());
+        failures++;
+    }
+    int entry = karel_compile("while no_beepers_present { turn_right "
+                              "while front_is_blocked { turn_left } move }");
+    for (int dim = 8; dim <= BOARD_MAX_ROWS; dim *= 2) {
+        maze_generate(dim, dim, 107, MAZE_WILSON);
+        karel_sim_init((pos_t) {0, dim - 1, EAST});
+
+        start = now_seconds();
+        karel_vm_result_t result = karel_vm_run(karel_bytecode(), entry,
+                                                1u << 30, NULL, 0);
+        elapsed = now_seconds() - start;
+
+        printf("karel: %dx%d maze, status %d after %u instructions "
+               "(%.1f million/s)\n", dim, dim, result.status,
+               result.instructions, result.instructions / elapsed / 1e6);
+        failures += result.status != VM_FINISHED;
+    }
+
+    // 5. raw dispatch speed: loops and tests that do not move Karel
+    entry = karel_compile("repeat 20000 { repeat 1000 { "
+                          "if facing_east { } if front_is_clear { } } }");
+    start = now_seconds();
+    karel_vm_result_t spin = karel_vm_run(karel_bytecode(), entry, 1u << 30, NULL, 0);
+    elapsed = now_seconds() - start;
+    printf("karel: %u instructions in %.3f s (%.1f million/s)\n",
+           spin.instructions, elapsed, spin.instructions / elapsed / 1e6);
+    failures += spin.status != VM_HALTED;
+
+    // 6. record a session far longer than the ring holds, then
+    // replay what is left and check Karel ends up in the same place
+    maze_generate(BOARD_MAX_ROWS, BOARD_MAX_COLS, 107, MAZE_BACKTRACKER);
+    karel_sim_init((pos_t) {0, BOARD_MAX_ROWS - 1, EAST});
+    unsigned int now_us = 0;
+    replay_record_start(karel_sim_position(), now_us);
+    for (int i = 0; i < (int) sizeof(moves); i++) {
+        now_us += 1000 * (rand() % 400);
+        replay_record(moves[i], now_us);
+        karel_sim_step(moves[i]);
+    }
+    pos_t live = karel_sim_position();
+
+    start = now_seconds();
+    replay_result_t replayed = replay_run(NULL, NULL);
+    elapsed = now_seconds() - start;
+    pos_t end = karel_sim_position();
+
+    printf("replay: %d of %d moves kept in %d bytes, replayed in %.3f ms, %s\n",
+           replay_num_moves(), (int) sizeof(moves), replay_size(), elapsed * 1e3,
+           (end.x == live.x && end.y == live.y && end.dir == live.dir)
+           ? "same end" : "DIFFERENT end");
+    failures += end.x != live.x || end.y != live.y || end.dir != live.dir;
+    failures += replayed.moves != (unsigned int) replay_num_moves();
+
+    // 7. journal a long walk, then check undo and jumps against
+    // the positions Karel actually went through
+    karel_sim_init((pos_t) {0, BOARD_MAX_ROWS - 1, EAST});
+    journal_init(karel_sim_position());
+    history[0] = karel_sim_position();
+    int steps = 0;
+    for (int i = 0; steps < JOURNAL_MAX_STEPS; i++) {
+        int move = moves[i & (sizeof(moves) - 1)];
+        if (karel_sim_step(move) != SIM_BLOCKED && journal_push(move)) {
+            history[++steps] = karel_sim_position();
+        }
+    }
+
+    int bad = 0;
+    start = now_seconds();
+    for (int i = 0; i < 10000; i++) {
+        int step = rand() % (steps + 1);
+        journal_goto(step);
+        pos_t pos = karel_sim_position();
+        bad += pos.x != history[step].x || pos.y != history[step].y
+            || pos.dir != history[step].dir;
+    }
+    double goto_s = now_seconds() - start;
+
+    start = now_seconds();
+    while (journal_undo() >= 0) {
+        pos_t pos = karel_sim_position();
+        int step = journal_step();
+        bad += pos.x != history[step].x || pos.y != history[step].y;
+    }
+    elapsed = now_seconds() - start;
+    while (journal_redo() >= 0) {}
+    bad += journal_step() != steps;
+
+    printf("journal: %d moves in %d bytes, %.2f us per jump, "
+           "%.1f ns per undo, %d mismatches\n", steps, steps / 4,
+           goto_s / 10000 * 1e6, elapsed / steps * 1e9, bad);
+    failures += bad != 0;
+
+    // 8. the same with beepers scattered around, picked up and
+    // put down again; jumps must put them all back
+    maze_generate(32, 32, 107, MAZE_KRUSKAL);
+    for (int i = 0; i < 200; i++) {
+        tiles_add_beeper(rand() % 32, rand() % 32);
+    }
+    karel_sim_init((pos_t) {0, 31, EAST});
+    karel_sim_set_bag(0);
+    journal_init(karel_sim_position());
+    bag_history[0] = 0;
+    total_history[0] = tiles_total_beepers();
+    history[0] = karel_sim_position();
+    steps = bad = 0;
+    for (int i = 0; steps < 100000; i++) {
+        int move = rand() % 32 ? moves[i & (sizeof(moves) - 1)]
+                               : PICK_BEEPER + rand() % 2;
+        if (karel_sim_step(move) != SIM_BLOCKED) {
+            bad += !journal_push(move);
+            steps++;
+            history[steps] = karel_sim_position();
+            bag_history[steps] = karel_sim_bag();
+            total_history[steps] = tiles_total_beepers();
+        }
+    }
+
+    for (int i = 0; i < 2000; i++) {
+        int step = rand() % (steps + 1);
+        journal_goto(step);
+        pos_t pos = karel_sim_position();
+        bad += pos.x != history[step].x || pos.y != history[step].y
+            || karel_sim_bag() != bag_history[step]
+            || tiles_total_beepers() != total_history[step];
+    }
+    printf("journal: %d moves with beepers, %d mismatches\n", steps, bad);
+    failures += bad != 0;
+
+    // 9. stream samples through the simulated sensor's FIFO, with
+    // drains at odd times, a half-read sample and an overrun
+    i2c_init();
+    lsm6ds33_init();
+    sensor_fifo_start(FIFO_RATE_1660HZ, 32);
+    int pushed = 0, popped = 0, transfers = lsm6ds33_sim_transfers();
+    bad = 0;
+    for (int i = 0; i < 100000; i++) {
+        short gyro[3] = {pushed, -pushed, pushed * 3};
+        short accel[3] = {pushed * 5, 7, -pushed};
+        lsm6ds33_sim_push(gyro, accel);
+        pushed++;
+
+        if (rand() % 40 == 0) {
+            sensor_fifo_drain();
+            sensor_sample_t sample;
+            while (sensor_fifo_pop(&sample)) {
+                short n = sample.gyro[0];
+                bad += n != (short) popped || sample.gyro[1] != (short) -n
+                    || sample.gyro[2] != (short) (n * 3) || sample.accel[0] != (short) (n * 5)
+                    || sample.accel[1] != 7 || sample.accel[2] != (short) -n;
+                popped++;
+            }
+        }
+    }
+    int per_drain = lsm6ds33_sim_transfers() - transfers;
+
+    unsigned char half[4];
+    lsm6ds33_read_regs(FIFO_DATA_OUT_L, half, sizeof(half)); // two words of a sample
+    for (int i = 0; i < 1000; i++) {
+        short sample_words[3] = {1, 2, 3};
+        lsm6ds33_sim_push(sample_words, sample_words);
+    }
+    sensor_fifo_drain();
+    sensor_sample_t sample;
+    int after_overrun = 0;
+    while (sensor_fifo_pop(&sample)) {
+        bad += sample.gyro[0] != 1 || sample.gyro[2] != 3 || sample.accel[1] != 2;
+        after_overrun++;
+    }
+    bad += sensor_fifo_overruns() != 1 || after_overrun != SENSOR_RING_SIZE;
+
+    printf("sensor fifo: %d of %d samples streamed in %d transfers, "
+           "%d after an overrun, %d mismatches\n",
+           popped, pushed, per_drain, after_overrun, bad);
+    failures += bad != 0;
+
+    // 10. replay a recorded session through the gesture recogniser and
+    // the old raw thresholds, counting missed and false moves
+    int disturbances;
+    int ngestures = make_trace(&disturbances);
+    int found, false_moves, latency_ms[2];
+    int raw_found, raw_false, raw_latency_ms[2];
+    score_trace(ngestures, 1, 0, &raw_found, &raw_false, raw_latency_ms);
+    score_trace(ngestures, 0, 0, &found, &false_moves, latency_ms);
+
+    printf("gestures: %d of %d recognised, %d false moves from %d knocks and jiggles, "
+           "%d ms to a step, %d ms to a turn\n",
+           found, ngestures, false_moves, disturbances, latency_ms[0], latency_ms[1]);
+    printf("raw thresholds: %d of %d recognised, %d false moves\n",
+           raw_found, ngestures, raw_false);
+    failures += found != ngestures || false_moves != 0;
+
+    // 11. fixed-point arithmetic against double, and its speed
+    double mul_err = 0, div_err = 0, sqrt_err = 0, atan_err = 0;
+    for (int i = 0; i < 1000000; i++) {
+        fixed_t a = random_fixed(150), b = random_fixed(150);
+        double exact = to_double(a) * to_double(b);
+        mul_err = fmax(mul_err, fabs(to_double(fixed_mul(a, b)) - exact) * FIXED_ONE);
+        if (b != 0 && fabs(to_double(a) / to_double(b)) < 30000) {
+            exact = to_double(a) / to_double(b);
+            div_err = fmax(div_err, fabs(to_double(fixed_div(a, b)) - exact) * FIXED_ONE);
+        }
+        fixed_t c = a < 0 ? -a : a;
+        sqrt_err = fmax(sqrt_err, fabs(to_double(fixed_sqrt(c)) - sqrt(to_double(c))) * FIXED_ONE);
+        double angle = atan2(to_double(a), to_double(b)) * DEGREES_PER_RADIAN;
+        atan_err = fmax(atan_err, fabs(to_double(fixed_atan2(a, b)) - angle));
+    }
+    printf("fixed: largest error %.2f lsb in mul, %.2f in div, %.2f in sqrt, "
+           "%.3f degrees in atan2\n", mul_err, div_err, sqrt_err, atan_err);
+    failures += mul_err > 0.5 || div_err > 1 || sqrt_err > 1 || atan_err > 0.3;
+
+    fixed_t xs[1024], ys[1024];
+    for (int i = 0; i < 1024; i++) {
+        xs[i] = random_fixed(150);
+        ys[i] = random_fixed(150) | 1;
+    }
+    const int n = 20000000;
+    printf("fixed: millions per second: %.0f mul, %.0f div, %.0f add_sat, %.0f sqrt, %.0f atan2\n",
+           bench_mul(xs, ys, n), bench_div(xs, ys, n), bench_add_sat(xs, ys, n),
+           bench_sqrt(xs, ys, n), bench_atan2(xs, ys, n));
+
+    // 12. the session again on a board that reads 25 dps on y and z,
+    // and 220 mg off on x and z, at rest, without and with calibration
+    // from its first second
+    for (int i = 0; i < TRACE_SAMPLES; i++) {
+        trace[i].gyro[1] += 2858;
+        trace[i].gyro[2] += 2858;
+        trace[i].accel[0] -= 3604;
+        trace[i].accel[2] -= 3604;
+    }
+    calibration_t cal;
+    int calibrated = calibration_compute(trace, TRACE_RATE, &cal);
+    int off_found, off_false;
+    score_trace(ngestures, 0, 0, &off_found, &off_false, latency_ms);
+    score_trace(ngestures, 0, &cal, &found, &false_moves, latency_ms);
+
+    printf("calibration: bias %d dps, %d mg; %d of %d recognised with %d false moves, "
+           "uncalibrated %d with %d\n",
+           cal.gyro_bias[2] * 7 / 800, cal.accel_bias[2] * 61 / 1000,
+           found, ngestures, false_moves, off_found, off_false);
+    failures += !calibrated || found != ngestures || false_moves != 0;
+
+    // 13. the same session through the simulated chip, drained every
+    // 100 ms with the moves queued by the drain handler
+    gesture_init(TRACE_RATE);
+    gesture_calibrate(&cal);
+    move_queue_clear();
+    sensor_fifo_set_drain_handler(recognise);
+    sensor_fifo_start(FIFO_RATE_104HZ, 8);
+    int queued = 0, dropped = move_queue_dropped();
+    for (int i = 0; i < TRACE_SAMPLES; i++) {
+        lsm6ds33_sim_push(trace[i].gyro, trace[i].accel);
+        if (i % (TRACE_RATE / 10) == 0 || i == TRACE_SAMPLES - 1) {
+            sensor_fifo_drain_start();
+            while (move_queue_pop() >= 0) {
+                queued++;
+            }
+        }
+    }
+    sensor_fifo_set_drain_handler(0);
+    dropped = move_queue_dropped() - dropped;
+    printf("move queue: %d moves queued from the chip, %d dropped\n", queued, dropped);
+    failures += queued != found + false_moves || dropped != 0;
+
+    // 14. play every level through the input sources, with the solver's
+    // path as the script, then time the largest level over and over
+    input_init();
+    input_add(&queued_moves);
+    input_add(&input_script);
+    int played = 0, unfinished = 0;
+    for (int dim = 4; dim <= BOARD_MAX_ROWS; dim *= 2) {
+        for (unsigned int seed = 1; seed <= 8; seed++) {
+            maze_generate(dim, dim, seed, MAZE_BACKTRACKER);
+            pos_t level_start = {0, dim - 1, EAST};
+            int len = solver_find_path(level_start, dim - 1, 0, path, MAX_PATH);
+            input_script_load(path, len);
+            unfinished += len <= 0 || play_level(level_start) != len;
+            played++;
+        }
+    }
+
+    pos_t level_start = {0, BOARD_MAX_ROWS - 1, EAST};
+    maze_generate(BOARD_MAX_ROWS, BOARD_MAX_COLS, 107, MAZE_BACKTRACKER);
+    int path_len = solver_find_path(level_start, BOARD_MAX_COLS - 1, 0, path, MAX_PATH);
+    long input_moves = 0;
+    int playthroughs = 0;
+    start = now_seconds();
+    unfinished += path_len <= 0;
+    while (path_len > 0 && input_moves < total_moves / 4) {
+        input_script_load(path, path_len);
+        unfinished += play_level(level_start) != path_len;
+        input_moves += path_len;
+        playthroughs++;
+    }
+    elapsed = now_seconds() - start;
+    printf("input: %d levels played from scripts, %d unfinished; %d playthroughs of %d moves "
+           "in %.3f s (%.1f million moves/s)\n", played, unfinished,
+           playthroughs, path_len, elapsed, input_moves / elapsed / 1e6);
+    failures += unfinished != 0;
+
+    return failures ? 1 : 0;
+}
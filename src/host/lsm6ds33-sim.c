@@ -0,0 +1,142 @@
+/*
+ * FILENAME: lsm6ds33-sim.c
+ * ------------------------------------------------
+ * Implements i2c.h for the host with a simulated
+ * LSM6DS33. The first byte written sets the register
+ * address, which moves on after every byte read or
+ * written, except that reading FIFO_DATA_OUT_H takes
+ * the next word out of the FIFO and goes back to
+ * FIFO_DATA_OUT_L, like the real chip.
+ */
+
+#include "i2c.h"
+#include "LSM6DS33.h"
+#include "lsm6ds33-sim.h"
+
+#define FIFO_WORDS 4096      // 8 KB
+#define WORDS_PER_SAMPLE 6
+#define FIFO_MODE_MASK 0x7
+
+static unsigned char regs[0x80];
+static unsigned char address;
+static int transfers;
+
+static unsigned short fifo[FIFO_WORDS];
+static int fifo_head;
+static int fifo_count;
+static int pattern; // word of the sample read next
+static int overrun;
+
+static int fifo_on(void) {
+    return (regs[FIFO_CTRL5] & FIFO_MODE_MASK) != 0;
+}
+
+static void drop_word(void) {
+    fifo_head = (fifo_head + 1) % FIFO_WORDS;
+    fifo_count--;
+    pattern = (pattern + 1) % WORDS_PER_SAMPLE;
+}
+
+static void write_reg(unsigned char reg, unsigned char value) {
+    regs[reg & 0x7f] = value;
+    if (reg == FIFO_CTRL5 && !fifo_on()) {
+        fifo_count = pattern = overrun = 0; // bypass mode empties the FIFO
+    }
+}
+
+static unsigned char read_reg(void) {
+    unsigned char reg = address++;
+    int threshold = regs[FIFO_CTRL1] | (regs[FIFO_CTRL2] & 0x0f) << 8;
+
+    switch (reg) {
+    case FIFO_STATUS1:
+        return fifo_count & 0xff;
+    case FIFO_STATUS2:
+        return (fifo_count >= threshold) << 7 | overrun << 6
+               | (fifo_count == FIFO_WORDS) << 5 | (fifo_count == 0) << 4
+               | (fifo_count >> 8 & 0x0f);
+    case FIFO_STATUS3:
+        return pattern & 0xff;
+    case FIFO_STATUS4:
+        return pattern >> 8;
+    case FIFO_DATA_OUT_L:
+        return fifo_count ? fifo[fifo_head] & 0xff : 0;
+    case FIFO_DATA_OUT_H: {
+        unsigned char high = fifo_count ? fifo[fifo_head] >> 8 : 0;
+        if (fifo_count) {
+            drop_word();
+            overrun = 0;
+        }
+        address = FIFO_DATA_OUT_L;
+        return high;
+    }
+    default:
+        return regs[reg & 0x7f];
+    }
+}
+
+void i2c_init(void) {
+    regs[WHO_AM_I] = 0x69;
+    regs[CTRL3_C] = 0x04; // IF_INC
+}
+
+void i2c_set_clock(unsigned int hz) {}
+
+int i2c_write(unsigned peripheral_address, char *data, int data_length) {
+    transfers++;
+    if (data_length < 1) return I2C_OK;
+
+    address = data[0];
+    for (int i = 1; i < data_length; i++) {
+        write_reg(address++, data[i]);
+    }
+    return I2C_OK;
+}
+
+int i2c_read(unsigned peripheral_address, char *data, int data_length) {
+    transfers++;
+    for (int i = 0; i < data_length; i++) {
+        data[i] = read_reg();
+    }
+    return I2C_OK;
+}
+
+void i2c_interrupts_enable(void) {}
+
+void i2c_check_timeouts(void) {}
+
+// done at once, as on the Pi before interrupts are enabled
+int i2c_submit(i2c_xfer_t *xfer) {
+    if (xfer->write_len > 0) {
+        i2c_write(xfer->address, (char *) xfer->write, xfer->write_len);
+    }
+    if (xfer->read_len > 0) {
+        i2c_read(xfer->address, (char *) xfer->read, xfer->read_len);
+    }
+    if (xfer->done) {
+        xfer->done(I2C_OK, xfer->aux);
+    }
+    return 1;
+}
+
+int i2c_transfer(i2c_xfer_t *xfer) {
+    xfer->done = 0;
+    i2c_submit(xfer);
+    return I2C_OK;
+}
+
+void lsm6ds33_sim_push(const short gyro[3], const short accel[3]) {
+    if (!fifo_on()) return;
+
+    for (int i = 0; i < WORDS_PER_SAMPLE; i++) {
+        if (fifo_count == FIFO_WORDS) {
+            drop_word();
+            overrun = 1;
+        }
+        fifo[(fifo_head + fifo_count++) % FIFO_WORDS] = i < 3 ? gyro[i] : accel[i - 3];
+    }
+}
+
+int lsm6ds33_sim_transfers(void) {
+    return transfers;
+}
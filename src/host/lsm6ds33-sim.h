@@ -0,0 +1,34 @@
+#ifndef LSM6DS33_SIM_H
+#define LSM6DS33_SIM_H
+
+/*
+ * FILENAME: lsm6ds33-sim.h
+ * -------------------------------------------------
+ * A simulated LSM6DS33 behind i2c_read, i2c_write and
+ * i2c_submit, so LSM6DS33.c and sensor_fifo.c run on
+ * the host. Submitted transfers finish at once.
+ * It keeps the chip's register map and its FIFO.
+ */
+
+/*
+ * 'lsm6ds33_sim_push'
+ *
+ * Adds a sample to the chip's FIFO, as the chip does
+ * at its FIFO rate when the FIFO is on. When full,
+ * the oldest words are lost and the chip reports an
+ * overrun.
+ *
+ * @params  gyroscope and accelerometer x, y and z
+ * @returns none
+ */
+void lsm6ds33_sim_push(const short gyro[3], const short accel[3]);
+
+/*
+ * 'lsm6ds33_sim_transfers'
+ *
+ * @params  none
+ * @returns number of I2C reads and writes so far
+ */
+int lsm6ds33_sim_transfers(void);
+
+#endif
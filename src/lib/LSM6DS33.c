@@ -7,8 +7,8 @@
 	SCL = gpio pin3
 
     void i2c_init(void);
-    void i2c_read(unsigned slave_address, char *data, int data_length);
-    void i2c_write(unsigned slave_address, char *data, int data_length);
+    int i2c_read(unsigned slave_address, char *data, int data_length);
+    int i2c_write(unsigned slave_address, char *data, int data_length);
 
     i2c slave address:
       Below are the i2c addresses for https://www.pololu.com/product/2738
@@ -33,17 +33,31 @@ void lsm6ds33_write_reg(unsigned char reg, unsigned char v) {
 }
 
 unsigned lsm6ds33_read_reg(unsigned char reg) {
-	i2c_write(lsm6ds33_address, (void*) &reg, 1);
 	unsigned char uc = 0;
-	i2c_read(lsm6ds33_address, (void*) &uc, 1);
+	lsm6ds33_read_regs(reg, &uc, 1);
 	return uc;
 }
 
+// the chip moves to the next register after each byte (IF_INC in CTRL3_C);
+// one transfer, so a queued one cannot move the register between address and read
+void lsm6ds33_read_regs(unsigned char reg, unsigned char *data, int len) {
+    i2c_xfer_t xfer = {lsm6ds33_address, &reg, 1, data, len};
+    i2c_transfer(&xfer);
+}
+
+// the chip sends each value low byte first
+void lsm6ds33_unpack_xyz(const unsigned char *data, short xyz[3]) {
+    for (int i = 0; i < 3; i++) {
+        xyz[i] = data[2 * i] | data[2 * i + 1] << 8;
+    }
+}
+
 void lsm6ds33_init() {
     //printf("accelerometer init\n"); 
 	lsm6ds33_write_reg(CTRL2_G, 0x80);   // 1600Hz (high perf mode)
     //printf("write register\n"); 
 	lsm6ds33_write_reg(CTRL1_XL, 0x80);  // 1600Hz (high perf mode)
+    lsm6ds33_write_reg(CTRL3_C, 0x44);   // BDU: both bytes of a value from one sample, IF_INC
 }
 
 unsigned lsm6ds33_get_whoami() {
@@ -63,25 +77,30 @@ void lsm6ds33_enable_accelerometer() {
 	lsm6ds33_write_reg(CTRL9_XL, 0x38);  // ACCEL: x,y,z enabled (bits 4-6)
 }
 
-void lsm6ds33_read_gyroscope(short *x, short *y, short *z) {
-    *x =  lsm6ds33_read_reg(OUTX_L_G);
-    *x |= lsm6ds33_read_reg(OUTX_H_G) << 8;
-
-    *y =  lsm6ds33_read_reg(OUTY_L_G);
-    *y |= lsm6ds33_read_reg(OUTY_H_G) << 8;
+// reads the three values of one sensor starting at reg
+static void read_xyz(unsigned char reg, short *x, short *y, short *z) {
+    unsigned char data[6];
+    short xyz[3];
+    lsm6ds33_read_regs(reg, data, sizeof(data));
+    lsm6ds33_unpack_xyz(data, xyz);
+    *x = xyz[0];
+    *y = xyz[1];
+    *z = xyz[2];
+}
 
-    *z =  lsm6ds33_read_reg(OUTZ_L_G);
-    *z |= lsm6ds33_read_reg(OUTZ_H_G) << 8;
+void lsm6ds33_read_gyroscope(short *x, short *y, short *z) {
+    read_xyz(OUTX_L_G, x, y, z);
 }
 
 void lsm6ds33_read_accelerometer(short *x, short *y, short *z) {
-    *x =  lsm6ds33_read_reg(OUTX_L_XL);
-    *x |= lsm6ds33_read_reg(OUTX_H_XL) << 8;
-
-    *y =  lsm6ds33_read_reg(OUTY_L_XL);
-    *y |= lsm6ds33_read_reg(OUTY_H_XL) << 8;
+    read_xyz(OUTX_L_XL, x, y, z);
+}
 
-    *z =  lsm6ds33_read_reg(OUTZ_L_XL);
-    *z |= lsm6ds33_read_reg(OUTZ_H_XL) << 8;
+// the gyroscope registers are followed directly by the accelerometer's
+void lsm6ds33_read_sample(short gyro[3], short accel[3]) {
+    unsigned char data[12];
+    lsm6ds33_read_regs(OUTX_L_G, data, sizeof(data));
+    lsm6ds33_unpack_xyz(data, gyro);
+    lsm6ds33_unpack_xyz(data + 6, accel);
 }
 
@@ -11,42 +11,176 @@
 #include "accel.h"
 #include "i2c.h"
 #include "LSM6DS33.h"
-#include "assert.h"
+#include "sensor_fifo.h"
+#include "gesture.h"
+#include "calibration.h"
+#include "move_queue.h"
+#include "gpio.h"
+#include "gpio_extra.h"
+#include "gpio_interrupts.h"
+#include "timer.h"
+#include "printf.h"
 
 const unsigned int LSM6DS33 = 0x69;
-const signed int ACC_THRESHOLD_Z = 600; // in mg
-const signed int GYR_THRESHOLD_Z = 1000; // in degrees
+const int SAMPLE_RATE_HZ = 104; // FIFO_RATE_104HZ
 
-void accel_init() {
-    i2c_init();
-    lsm6ds33_init();
-    assert(lsm6ds33_get_whoami() == LSM6DS33); // should be 69
+// the sensor's INT1 pin, raised while its FIFO holds WATERMARK samples or more
+#define INT1_PIN GPIO_PIN17
+#define INT1_FTH 0x08 // FIFO threshold on INT1, in INT1_CTRL
+#define WATERMARK 4   // about 40 ms of samples
 
-    lsm6ds33_enable_accelerometer();
-    lsm6ds33_enable_gyroscope();
-}
+// time INT1 is given to show up at startup before falling back on polling
+#define INT1_WAIT_US 100000
 
-int accel_read_move() {
+// 1 if INT1 is wired up and starts the drains, 0 if polls do
+static int use_int1;
 
-    // accelerometer and gyroscope
-    short xa, ya, za, xg, yg, zg;
+// set once the sensor is running; drains may be under way from then on
+static int sensor_running;
 
-    lsm6ds33_read_accelerometer(&xa, &ya, &za); 
-    lsm6ds33_read_gyroscope(&xg, &yg, &zg);
+// samples taken at rest to calibrate, at 833 Hz: about 150 ms
+#define CALIBRATION_SAMPLES 128
+#define CALIBRATION_TIMEOUT_US 500000
 
-    while (1) { // implements the delay
+static sensor_sample_t rest[CALIBRATION_SAMPLES];
 
-        if (zg / 16 > GYR_THRESHOLD_Z) {
-            return TURN_LEFT; 
+/*
+ * Measures the sensor at rest and hands the result
+ * to the gesture recogniser, which keeps its defaults
+ * if the board was being moved.
+ */
+static void calibrate(void) {
+    int n = 0;
+    unsigned int start = timer_get_ticks();
+
+    sensor_fifo_start(FIFO_RATE_833HZ, 16);
+    while (n < CALIBRATION_SAMPLES && timer_get_ticks() - start < CALIBRATION_TIMEOUT_US) {
+        sensor_fifo_drain();
+        while (n < CALIBRATION_SAMPLES && sensor_fifo_pop(&rest[n])) {
+            n++;
         }
+    }
 
-        if (za / 16 < ACC_THRESHOLD_Z) {
-            return MOVE_FORWARD;
+    calibration_t cal;
+    if (!calibration_compute(rest, n, &cal)) {
+        printf("calibration: board not at rest, using defaults\n");
+        return;
+    }
+    gesture_calibrate(&cal);
+    printf("calibration: gyro bias %d %d %d noise %d %d %d, "
+           "accel bias %d %d %d noise %d %d %d, in %d us\n",
+           cal.gyro_bias[0], cal.gyro_bias[1], cal.gyro_bias[2],
+           cal.gyro_noise[0], cal.gyro_noise[1], cal.gyro_noise[2],
+           cal.accel_bias[0], cal.accel_bias[1], cal.accel_bias[2],
+           cal.accel_noise[0], cal.accel_noise[1], cal.accel_noise[2],
+           timer_get_ticks() - start);
+}
+
+/*
+ * Runs the samples of each drain through the gesture
+ * recogniser and queues the moves it finds. Called
+ * from the I2C interrupt once interrupts are on.
+ */
+static void recognise(void) {
+    sensor_sample_t sample;
+    while (sensor_fifo_pop(&sample)) {
+        int move = gesture_feed(&sample);
+        if (move >= 0) {
+            move_queue_push(move);
         }
+    }
+
+    // more samples came in while draining: INT1 stays high and will not rise again
+    if (use_int1 && gpio_read(INT1_PIN)) {
+        sensor_fifo_drain_start();
+    }
+}
+
+// the FIFO reached the watermark: fetch the samples
+static void int1_raised(unsigned int pc, void *aux_data) {
+    gpio_check_and_clear_event(INT1_PIN);
+    sensor_fifo_drain_start();
+}
+
+/*
+ * Routes the FIFO threshold to INT1 and has rising
+ * edges start a drain, if INT1 turns out to be wired
+ * to INT1_PIN; otherwise polls keep starting drains.
+ */
+static void int1_init(void) {
+    gpio_set_input(INT1_PIN);
+    gpio_set_pulldown(INT1_PIN); // stays low if nothing is connected
+    lsm6ds33_write_reg(INT1_CTRL, INT1_FTH);
+
+    unsigned int start = timer_get_ticks();
+    while (!gpio_read(INT1_PIN) && timer_get_ticks() - start < INT1_WAIT_US)
+        ;
+    if (!gpio_read(INT1_PIN)) {
+        printf("accel: no INT1 on GPIO %d, polling the sensor\n", INT1_PIN);
+        lsm6ds33_write_reg(INT1_CTRL, 0);
+        return;
+    }
+
+    // INT1 is already high, so no edge is coming: drain before edges can
+    // start drains too; when it is over, recognise checks INT1 again
+    use_int1 = 1;
+    sensor_fifo_drain_start();
+
+    gpio_interrupts_init();
+    gpio_enable_event_detection(INT1_PIN, GPIO_DETECT_RISING_EDGE);
+    gpio_interrupts_register_handler(INT1_PIN, int1_raised, NULL);
+    gpio_interrupts_enable();
+}
 
+int accel_init() {
+    // calibrating again would race the drains for samples, and
+    // resetting the bus could cut one off mid-transfer
+    if (sensor_running) return 1;
 
-        lsm6ds33_read_accelerometer(&xa, &ya, &za);
-        lsm6ds33_read_gyroscope(&xg, &yg, &zg);
+    timer_init(); // sets up interrupts for the I2C queue
+    i2c_init();
+    if (lsm6ds33_get_whoami() != LSM6DS33) { // should be 69
+        printf("accel: no LSM6DS33 on the I2C bus\n");
+        return 0;
     }
+    lsm6ds33_init();
+
+    lsm6ds33_enable_accelerometer();
+    lsm6ds33_enable_gyroscope();
+
+    gesture_init(SAMPLE_RATE_HZ);
+    calibrate();
+
+    // the chip collects samples between drains; 104 Hz keeps the bus mostly free
+    move_queue_clear();
+    sensor_fifo_set_drain_handler(recognise);
+    sensor_fifo_start(FIFO_RATE_104HZ, WATERMARK);
+    i2c_interrupts_enable();
+    int1_init();
+    sensor_running = 1;
+    return 1;
+}
+
+int accel_poll_move() {
+    i2c_check_timeouts(); // a drain stuck on the bus would stop the sensor for good
+
+    // without INT1, fetch the samples collected since the last poll; moves
+    // found in them are queued when they arrive, so this returns without waiting
+    if (!use_int1) {
+        sensor_fifo_drain_start();
+    }
+    return move_queue_pop();
+}
+
+int accel_uses_int1() {
+    return use_int1;
+}
+
+int accel_read_move() {
+    int move;
+
+    while ((move = accel_poll_move()) < 0) {} // implements the delay
+    return move;
 }
 
+const input_source_t input_sensor = {"sensor", accel_init, accel_poll_move, move_queue_clear};
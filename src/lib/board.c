@@ -9,8 +9,8 @@
  */
 
 #include "board.h"
+#include "tiles.h"
 #include "gl.h"
-#include "strings.h"
 #include "printf.h"
 #include "console.h"
 
@@ -26,20 +26,45 @@
 const unsigned int BOX_SIZE = 64;
 const color_t BG_COLOR = GL_WHITE;
 const color_t WALL_COLOR = GL_BLACK;
-static board_config_t cur_board;
+const color_t HINT_COLOR = GL_RED;
+const color_t BEEPER_COUNT_COLOR = GL_BLUE;
+const unsigned int HINT_SIZE = 8;
 const unsigned int ASCII_10 = 48;
 
+// cells highlighted by the hint overlay
+#define MAX_HINT 64
+static struct {
+    int x[MAX_HINT];
+    int y[MAX_HINT];
+    int count;
+} hint;
+
 // keeps track of where the top left of the display is
 struct point_t {
     int x;
     int y;
 } top_left;
 
+// frames that must still redraw the whole board, one per buffer
+static int full_redraws;
+
+// cells Karel covered in the last frame, on the screen
+static struct {
+    int x[2];
+    int y[2];
+    int count;
+} karel_cells;
+
+// sine of 0 to 90 degrees in 16 steps, times 4096
+static const short sin_q12[17] = {
+    0, 401, 799, 1189, 1567, 1931, 2276, 2598, 2896,
+    3166, 3406, 3612, 3784, 3920, 4017, 4076, 4096,
+};
+
 void board_init(const char *input_board[], int nrows, int display_dim) {
 
     // set up board
-    cur_board = (board_config_t) {(char **)input_board, nrows, 
-                strlen(input_board[0]), display_dim};
+    board_load(input_board, nrows, display_dim);
 
     // establish top left corner of displayed screen
     top_left.x = 0;
@@ -50,6 +75,18 @@ void board_init(const char *input_board[], int nrows, int display_dim) {
             GL_DOUBLEBUFFER);
 }
 
+void board_set_hint(const int *xs, const int *ys, int count) {
+    if (count > MAX_HINT) count = MAX_HINT;
+    if (count > 0 || hint.count > 0) {
+        full_redraws = 2; // dots may be anywhere on the screen
+    }
+    for (int i = 0; i < count; i++) {
+        hint.x[i] = xs[i];
+        hint.y[i] = ys[i];
+    }
+    hint.count = count;
+}
+
 /*
  * Draws the central plus in a box. Draws it in
  * the buffer function was called in.
@@ -99,22 +136,57 @@ void draw_hline(int x, int y, int length) {
 }
 
 /*
- * Scrolls the board in a particular given 
- * direction, provided there is more outside
- * the displayed dimensions
+ * Scrolls the board just enough to keep Karel
+ * in the displayed part of the board. Usually
+ * Karel has moved one cell past an edge, but
+ * this also catches up after a new board was
+ * loaded with board_new.
  *
- * @params  direction to be scrolled
- * @precon  only called when we are at edge
+ * @params  Karel's position
  */
 void scroll(int x, int y) {
-    if (x == top_left.x + cur_board.display_size) {
-        top_left.x++;
-    } else if (y < top_left.y) {
-        top_left.y--;
+    int size = board_get_config()->display_size;
+
+    if (x >= top_left.x + size) {
+        top_left.x = x - size + 1;
     } else if (x < top_left.x) {
-        top_left.x--;
-    } else if (y == top_left.y + cur_board.display_size) {
-        top_left.y++;
+        top_left.x = x;
+    }
+
+    if (y >= top_left.y + size) {
+        top_left.y = y - size + 1;
+    } else if (y < top_left.y) {
+        top_left.y = y;
+    }
+}
+
+/*
+ * Draws every tile of the given kind that is
+ * inside the displayed part of the board, using
+ * the tile index instead of scanning the board.
+ *
+ * @params  kind of tile, image to draw for it
+ * @returns none
+ */
+void draw_tiles(int kind, const unsigned char *image) {
+    const tile_pos_t *tiles = tiles_list(kind);
+    int count = tiles_count(kind);
+    int size = board_get_config()->display_size;
+
+    for (int i = 0; i < count; i++) {
+        int x = tiles[i].x - top_left.x;
+        int y = tiles[i].y - top_left.y;
+        if (x >= 0 && x < size && y >= 0 && y < size) {
+            gl_draw_image(image, BOX_SIZE, BOX_SIZE, x * BOX_SIZE, y * BOX_SIZE);
+
+            // stacks of beepers show how many there are
+            int beepers = kind == BEEPER ? tiles_beepers(tiles[i].x, tiles[i].y) : 0;
+            if (beepers > 1) {
+                char count[12];
+                snprintf(count, sizeof(count), "%d", beepers);
+                gl_draw_string(x * BOX_SIZE + 2, y * BOX_SIZE + 2, count, BEEPER_COUNT_COLOR);
+            }
+        }
     }
 }
 
@@ -191,53 +263,177 @@ void draw_end() {
   gl_swap_buffer(); 
 }
 
-void draw_board(int karel_x, int karel_y, int direction) {
+/*
+ * Draws the plus and the walls of one cell.
+ *
+ * @params  x and y position of the cell on the screen
+ */
+static void draw_grid_cell(int x, int y) {
+    int walls = board_walls(x + top_left.x, y + top_left.y);
+
+    draw_central_plus(x * BOX_SIZE, y * BOX_SIZE);
+
+    // walls between cells are drawn from both sides, onto the same pixels
+    if (walls & WALL_BIT(NORTH)) draw_hline(x * BOX_SIZE, y * BOX_SIZE, BOX_SIZE);
+    if (walls & WALL_BIT(SOUTH)) draw_hline(x * BOX_SIZE, (y + 1) * BOX_SIZE, BOX_SIZE);
+    if (walls & WALL_BIT(WEST)) draw_vline(x * BOX_SIZE, y * BOX_SIZE, BOX_SIZE);
+    if (walls & WALL_BIT(EAST)) draw_vline((x + 1) * BOX_SIZE, y * BOX_SIZE, BOX_SIZE);
+}
+
+static void draw_hint_dot(int x, int y) {
+    gl_draw_rect(x * BOX_SIZE + BOX_SIZE / 2 - HINT_SIZE / 2,
+                 y * BOX_SIZE + BOX_SIZE / 2 - HINT_SIZE / 2,
+                 HINT_SIZE, HINT_SIZE, HINT_COLOR);
+}
+
+/*
+ * Draws everything in one cell but Karel, over
+ * whatever was drawn there before.
+ *
+ * @params  x and y position of the cell on the screen
+ */
+static void draw_cell(int x, int y) {
+    int size = board_get_config()->display_size;
+    if (x < 0 || x >= size || y < 0 || y >= size) return;
+
+    int board_x = x + top_left.x;
+    int board_y = y + top_left.y;
+    char tile = board_get_config()->board[board_y][board_x];
+
+    gl_draw_rect(x * BOX_SIZE, y * BOX_SIZE, BOX_SIZE, BOX_SIZE, BG_COLOR);
+    draw_grid_cell(x, y);
+
+    int beepers = tiles_beepers(board_x, board_y);
+    if (beepers > 0) {
+        gl_draw_image(beeper.pixel_data, BOX_SIZE, BOX_SIZE, x * BOX_SIZE, y * BOX_SIZE);
+        if (beepers > 1) {
+            char count[12];
+            snprintf(count, sizeof(count), "%d", beepers);
+            gl_draw_string(x * BOX_SIZE + 2, y * BOX_SIZE + 2, count, BEEPER_COUNT_COLOR);
+        }
+    }
+    if (tile == PAT) {
+        gl_draw_image(pat_web.pixel_data, BOX_SIZE, BOX_SIZE, x * BOX_SIZE, y * BOX_SIZE);
+    } else if (tile == JULIE) {
+        gl_draw_image(julie_whitebg.pixel_data, BOX_SIZE, BOX_SIZE, x * BOX_SIZE, y * BOX_SIZE);
+    }
+
+    for (int i = 0; i < hint.count; i++) {
+        if (hint.x[i] == board_x && hint.y[i] == board_y) {
+            draw_hint_dot(x, y);
+        }
+    }
+}
+
+/*
+ * Draws the whole displayed part of the board,
+ * without Karel.
+ */
+static void draw_background(void) {
     gl_clear(BG_COLOR);
 
-    int size = cur_board.display_size;
-    scroll(karel_x, karel_y);
+    int size = board_get_config()->display_size;
 
     // draw basic board
     for (int y = 0; y < size; y++) {
         for (int x = 0; x < size; x++) {
+            draw_grid_cell(x, y);
+        }
+    }
 
-            char path = (cur_board.board)[y + top_left.y][x + top_left.x];
-
-            draw_central_plus(x * BOX_SIZE, y * BOX_SIZE);
+    // draw special tiles that are in view
+    draw_tiles(BEEPER, beeper.pixel_data);
+    draw_tiles(PAT, pat_web.pixel_data);
+    draw_tiles(JULIE, julie_whitebg.pixel_data);
+
+    // draw hint overlay as a small dot in each cell
+    for (int i = 0; i < hint.count; i++) {
+        int x = hint.x[i] - top_left.x;
+        int y = hint.y[i] - top_left.y;
+        if (x >= 0 && x < size && y >= 0 && y < size) {
+            draw_hint_dot(x, y);
+        }
+    }
+}
 
-            if (path == SOUTH_WALL) { 
-                draw_hline(BOX_SIZE * x, BOX_SIZE * (y + 1), BOX_SIZE);
+static const unsigned char *karel_image(int direction) {
+    if (direction == NORTH) return karel_north.pixel_data;
+    if (direction == WEST) return karel_west.pixel_data;
+    if (direction == SOUTH) return karel_south.pixel_data;
+    return karel_east.pixel_data;
+}
 
-            } else if (path == WEST_WALL) {
-                draw_vline(x * BOX_SIZE, y * BOX_SIZE, BOX_SIZE);
+/*
+ * Draws Karel turned part of the way from one
+ * direction to another, using the sprite closest
+ * to where he is facing, rotated the rest of the way.
+ *
+ * @params  top left corner in pixels, direction
+ *          before and after the turn, how far along
+ *          the turn is (0 to KAREL_MOVE_STEPS)
+ */
+static void draw_karel(int x, int y, int from_dir, int to_dir, int progress) {
+    int turn = (to_dir - from_dir + 4) % 4; // quarter turns to the left
+    if (turn == 3) turn = -1;
+
+    // 16ths of a quarter turn so far, split into the nearest sprite and the rest
+    int angle = turn * 16 * progress / KAREL_MOVE_STEPS;
+    int quarters = (angle + 8 + 32) / 16 - 2;
+    int rest = angle - quarters * 16;
+    const unsigned char *image = karel_image((from_dir + quarters + 4) % 4);
+
+    if (rest == 0) {
+        gl_draw_image(image, BOX_SIZE, BOX_SIZE, x, y);
+    } else {
+        int sin_rest = rest > 0 ? sin_q12[rest] : -sin_q12[-rest];
+        int cos_rest = sin_q12[16 - (rest > 0 ? rest : -rest)];
+        gl_draw_image_rotated(image, BOX_SIZE, BOX_SIZE, x, y, sin_rest, cos_rest);
+    }
+}
 
-            } else if (path == BEEPER) {
-                gl_draw_image(beeper.pixel_data, BOX_SIZE, BOX_SIZE, 
-                                x * BOX_SIZE, y * BOX_SIZE);
+void draw_karel_move(int from_x, int from_y, int from_dir,
+                     int to_x, int to_y, int to_dir, int progress) {
+    int box = BOX_SIZE;
+    struct point_t old = top_left;
 
-            } else if (path == PAT) {
-                gl_draw_image(pat_web.pixel_data, BOX_SIZE, BOX_SIZE,
-                                x * BOX_SIZE, y * BOX_SIZE);
+    scroll(to_x, to_y);
+    if (top_left.x != old.x || top_left.y != old.y) {
+        full_redraws = 2;
+    }
 
-            } else if (path == JULIE) {
-                gl_draw_image(julie_whitebg.pixel_data, BOX_SIZE, BOX_SIZE,
-                                x * BOX_SIZE, y * BOX_SIZE);
-            }
+    // cells Karel covers on the screen
+    int xs[2] = {from_x - top_left.x, to_x - top_left.x};
+    int ys[2] = {from_y - top_left.y, to_y - top_left.y};
+    int count = (from_x == to_x && from_y == to_y) ? 1 : 2;
+
+    if (full_redraws > 0) {
+        full_redraws--;
+        draw_background();
+    } else {
+        // the buffer holds the frame before last, so clear Karel from there too
+        for (int i = 0; i < karel_cells.count; i++) {
+            draw_cell(karel_cells.x[i], karel_cells.y[i]);
+        }
+        for (int i = 0; i < count; i++) {
+            draw_cell(xs[i], ys[i]);
         }
     }
 
-    // draw karel
-    karel_x = (karel_x - top_left.x) * BOX_SIZE;
-    karel_y = (karel_y - top_left.y) * BOX_SIZE;
-    if (direction == EAST) 
-        gl_draw_image(karel_east.pixel_data, BOX_SIZE, BOX_SIZE, karel_x, karel_y); 
-    if (direction == NORTH) 
-        gl_draw_image(karel_north.pixel_data, BOX_SIZE, BOX_SIZE, karel_x, karel_y); 
-    if (direction == WEST) 
-        gl_draw_image(karel_west.pixel_data, BOX_SIZE, BOX_SIZE, karel_x, karel_y); 
-    if (direction == SOUTH) 
-        gl_draw_image(karel_south.pixel_data, BOX_SIZE, BOX_SIZE, karel_x, karel_y); 
+    for (int i = 0; i < count; i++) {
+        karel_cells.x[i] = xs[i];
+        karel_cells.y[i] = ys[i];
+    }
+    karel_cells.count = count;
+
+    int x = xs[0] * box + (xs[1] - xs[0]) * box * progress / KAREL_MOVE_STEPS;
+    int y = ys[0] * box + (ys[1] - ys[0]) * box * progress / KAREL_MOVE_STEPS;
+    draw_karel(x, y, from_dir, to_dir, progress);
 
     gl_swap_buffer();
 }
 
+void draw_board(int karel_x, int karel_y, int direction) {
+    full_redraws = 2; // the board may have changed anywhere
+    draw_karel_move(karel_x, karel_y, direction,
+                    karel_x, karel_y, direction, KAREL_MOVE_STEPS);
+}
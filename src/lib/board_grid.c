@@ -0,0 +1,133 @@
+
+/*
+ * FILENAME: board_grid.c
+ * ------------------------------------------------
+ * Keeps the cells of Karel's world and answers
+ * questions about them. Nothing here draws, so
+ * the engine can also run headless (see
+ * karel_sim.h) on a machine without a Pi.
+ *
+ * Besides the tiles, every cell keeps a mask of
+ * the walls on its four sides. A wall is stored
+ * in both cells it separates, and the edge of the
+ * board counts as a wall, so checking a move is a
+ * single bit test.
+ */
+
+#include "board.h"
+#include "tiles.h"
+#include "strings.h"
+
+static board_config_t cur_board;
+
+// the board is copied here so tiles can change during a game
+static char cells[BOARD_MAX_ROWS][BOARD_MAX_COLS + 1];
+static char *rows[BOARD_MAX_ROWS];
+static unsigned char walls[BOARD_MAX_ROWS][BOARD_MAX_COLS];
+
+static const int dx[4] = {1, 0, -1, 0}; // indexed by direction
+static const int dy[4] = {0, -1, 0, 1};
+
+// walls a tile brings with it
+static int tile_walls(char tile) {
+    if (tile == SOUTH_WALL) return WALL_BIT(SOUTH);
+    if (tile == WEST_WALL) return WALL_BIT(WEST);
+    if (tile == CORNER_WALL) return WALL_BIT(SOUTH) | WALL_BIT(WEST);
+    return 0;
+}
+
+/*
+ * Builds the wall masks from the tiles, walling
+ * in the edges of the board
+ */
+static void build_walls(void) {
+    int nrows = cur_board.num_rows, ncols = cur_board.num_cols;
+
+    for (int y = 0; y < nrows; y++) {
+        for (int x = 0; x < ncols; x++) {
+            walls[y][x] = 0;
+        }
+        walls[y][0] |= WALL_BIT(WEST);
+        walls[y][ncols - 1] |= WALL_BIT(EAST);
+    }
+    for (int x = 0; x < ncols; x++) {
+        walls[0][x] |= WALL_BIT(NORTH);
+        walls[nrows - 1][x] |= WALL_BIT(SOUTH);
+    }
+
+    for (int y = 0; y < nrows; y++) {
+        for (int x = 0; x < ncols; x++) {
+            int mask = tile_walls(cur_board.board[y][x]);
+            for (int dir = 0; dir < 4; dir++) {
+                if (mask & WALL_BIT(dir)) board_set_wall(x, y, dir, 1);
+            }
+        }
+    }
+}
+
+void board_load(const char *input_board[], int nrows, int display_dim) {
+    int ncols = strlen(input_board[0]);
+    for (int y = 0; y < nrows; y++) {
+        memcpy(cells[y], input_board[y], ncols + 1);
+        rows[y] = cells[y];
+    }
+    cur_board = (board_config_t) {rows, nrows, ncols, display_dim};
+    build_walls();
+    tiles_build((const char **)rows, nrows, ncols);
+}
+
+void board_new(int nrows, int ncols) {
+    for (int y = 0; y < nrows; y++) {
+        memset(cells[y], FREE, ncols);
+        cells[y][ncols] = '\0';
+        rows[y] = cells[y];
+    }
+    cur_board.board = rows;
+    cur_board.num_rows = nrows;
+    cur_board.num_cols = ncols;
+    build_walls();
+    tiles_build((const char **)rows, nrows, ncols);
+}
+
+const board_config_t *board_get_config(void) {
+    return &cur_board;
+}
+
+void board_set_tile(int x, int y, char tile) {
+    char old = cur_board.board[y][x];
+    cur_board.board[y][x] = tile;
+
+    int old_walls = tile_walls(old), new_walls = tile_walls(tile);
+    for (int dir = 0; dir < 4; dir++) {
+        if ((old_walls ^ new_walls) & WALL_BIT(dir)) {
+            board_set_wall(x, y, dir, new_walls & WALL_BIT(dir));
+        }
+    }
+    tiles_update(x, y, old, tile);
+}
+
+void board_set_wall(int x, int y, int dir, int present) {
+    int nx = x + dx[dir], ny = y + dy[dir];
+    int opposite = (dir + 2) % 4;
+
+    // the edge of the board stays walled in
+    if (nx < 0 || nx >= cur_board.num_cols || ny < 0 || ny >= cur_board.num_rows) {
+        return;
+    }
+
+    if (present) {
+        walls[y][x] |= WALL_BIT(dir);
+        walls[ny][nx] |= WALL_BIT(opposite);
+    } else {
+        walls[y][x] &= ~WALL_BIT(dir);
+        walls[ny][nx] &= ~WALL_BIT(opposite);
+    }
+}
+
+int board_walls(int x, int y) {
+    return walls[y][x];
+}
+
+int board_can_move(int x, int y, int dir) {
+    return !(walls[y][x] & WALL_BIT(dir));
+}
@@ -0,0 +1,61 @@
+
+/*
+ * FILENAME: calibration.c
+ * ------------------------------------------------
+ * Sums and sums of squares are kept in 64 bits, so
+ * any number of samples can be averaged. The square
+ * root of the variance comes from fixed_sqrt: read as
+ * Q16.16, v counts squared gives sqrt(v) * 256.
+ */
+
+#include "calibration.h"
+#include "fixed.h"
+
+#define MIN_SAMPLES 16
+
+// largest spread and tilt of a board at rest, in counts
+#define MAX_GYRO_NOISE  171  // 1.5 dps
+#define MAX_ACCEL_NOISE 492  // 30 mg
+#define MAX_TILT        4096 // 0.25 g on x or y, or off 1 g on z
+
+/*
+ * Mean and standard deviation of one axis of the
+ * gyroscope (0 to 2) or accelerometer (3 to 5)
+ */
+static void axis_stats(const sensor_sample_t *samples, int n, int axis,
+                       short *mean, short *noise) {
+    long long sum = 0, squares = 0;
+    for (int i = 0; i < n; i++) {
+        int v = axis < 3 ? samples[i].gyro[axis] : samples[i].accel[axis - 3];
+        sum += v;
+        squares += v * v;
+    }
+    long long variance = (squares - sum * sum / n) / n;
+    if (variance > FIXED_MAX) variance = FIXED_MAX;
+
+    *mean = sum / n;
+    *noise = fixed_sqrt(variance) >> (FIXED_SHIFT / 2);
+}
+
+int calibration_compute(const sensor_sample_t *samples, int n, calibration_t *cal) {
+    if (n < MIN_SAMPLES) return 0;
+
+    calibration_t result;
+    for (int axis = 0; axis < 3; axis++) {
+        axis_stats(samples, n, axis, &result.gyro_bias[axis], &result.gyro_noise[axis]);
+        axis_stats(samples, n, axis + 3, &result.accel_bias[axis], &result.accel_noise[axis]);
+        if (result.gyro_noise[axis] > MAX_GYRO_NOISE
+                || result.accel_noise[axis] > MAX_ACCEL_NOISE) {
+            return 0; // moving
+        }
+    }
+    result.accel_bias[2] -= CALIBRATION_ONE_G;
+    for (int axis = 0; axis < 3; axis++) {
+        if (result.accel_bias[axis] > MAX_TILT || result.accel_bias[axis] < -MAX_TILT) {
+            return 0; // not flat
+        }
+    }
+
+    *cal = result;
+    return 1;
+}
@@ -0,0 +1,267 @@
+
+/*
+ * FILENAME: distfield.c
+ * ------------------------------------------------
+ * Distance field from every (x, y, direction) state
+ * to the nearest beeper, stored as one 16-bit count
+ * per state.
+ *
+ * The field is built by searching backwards from
+ * the beepers: a state's predecessors are the state
+ * one left turn before it, and the state one cell
+ * behind it if moving forward from there is valid.
+ *
+ * When a tile changes, distfield_update first clears
+ * the states that lost their shortest path, then
+ * repairs those (and any that got closer) with a
+ * small Dijkstra search seeded at the changed cells.
+ */
+
+#include "distfield.h"
+#include "board.h"
+#include "tiles.h"
+#include "accel.h"
+
+#define MAX_STATES (BOARD_MAX_ROWS * BOARD_MAX_COLS * 4)
+#define DIST_INF 0xffff
+
+// states at the changed cell and its four neighbours
+#define MAX_SEEDS 20
+
+static unsigned short dist[MAX_STATES];
+
+// BFS queue, and worklist when clearing states
+static unsigned short work[2 * MAX_STATES + MAX_SEEDS];
+
+// states cleared by an update
+static unsigned short cleared[MAX_STATES];
+
+// binary heap of (distance << 16 | state) for repairs
+static unsigned int heap[3 * MAX_STATES + MAX_SEEDS];
+static int heap_size;
+
+static int num_rows, num_cols;
+
+static inline int state_of(int x, int y, int dir) {
+    return (y * num_cols + x) * 4 + dir;
+}
+
+static inline int is_goal(int state) {
+    int cell = state / 4;
+    return tiles_has_beeper(cell % num_cols, cell / num_cols);
+}
+
+/*
+ * Returns the state reached by moving forward from
+ * state, or -1 if the move is not valid
+ */
+static int move_successor(int state) {
+    int cell = state / 4, dir = state % 4;
+    int x = cell % num_cols, y = cell / num_cols;
+
+    if (!board_can_move(x, y, dir)) return -1;
+    x += (dir == EAST) - (dir == WEST);
+    y += (dir == SOUTH) - (dir == NORTH);
+    return state_of(x, y, dir);
+}
+
+/*
+ * Returns the state that reaches state by moving
+ * forward, or -1 if there is none
+ */
+static int move_predecessor(int state) {
+    int cell = state / 4, dir = state % 4;
+    int x = cell % num_cols - (dir == EAST) + (dir == WEST);
+    int y = cell / num_cols - (dir == SOUTH) + (dir == NORTH);
+
+    if (x < 0 || x >= num_cols || y < 0 || y >= num_rows
+            || !board_can_move(x, y, dir)) {
+        return -1;
+    }
+    return state_of(x, y, dir);
+}
+
+static inline int turn_successor(int state) {
+    return (state & ~3) | ((state + 1) & 3);
+}
+
+static inline int turn_predecessor(int state) {
+    return (state & ~3) | ((state + 3) & 3);
+}
+
+static void heap_push(unsigned int key) {
+    int i = heap_size++;
+    while (i > 0 && heap[(i - 1) / 2] > key) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = key;
+}
+
+static unsigned int heap_pop(void) {
+    unsigned int top = heap[0];
+    unsigned int last = heap[--heap_size];
+    int i = 0;
+
+    while (2 * i + 1 < heap_size) {
+        int child = 2 * i + 1;
+        if (child + 1 < heap_size && heap[child + 1] < heap[child]) child++;
+        if (heap[child] >= last) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+    return top;
+}
+
+void distfield_compute(void) {
+    const board_config_t *config = board_get_config();
+    num_rows = config->num_rows;
+    num_cols = config->num_cols;
+
+    int num_states = num_rows * num_cols * 4;
+    for (int i = 0; i < num_states; i++) {
+        dist[i] = DIST_INF;
+    }
+
+    // every direction on a beeper is a goal
+    int head = 0, tail = 0;
+    const tile_pos_t *beepers = tiles_list(BEEPER);
+    for (int i = 0; i < tiles_count(BEEPER); i++) {
+        for (int dir = 0; dir < 4; dir++) {
+            int state = state_of(beepers[i].x, beepers[i].y, dir);
+            dist[state] = 0;
+            work[tail++] = state;
+        }
+    }
+
+    while (head < tail) {
+        int state = work[head++];
+        int preds[2] = {turn_predecessor(state), move_predecessor(state)};
+
+        for (int i = 0; i < 2; i++) {
+            if (preds[i] >= 0 && dist[preds[i]] == DIST_INF) {
+                dist[preds[i]] = dist[state] + 1;
+                work[tail++] = preds[i];
+            }
+        }
+    }
+}
+
+/*
+ * Best distance for state given its successors'
+ * current distances
+ */
+static unsigned int best_from_successors(int state) {
+    if (is_goal(state)) return 0;
+
+    unsigned int best = DIST_INF;
+    int succs[2] = {turn_successor(state), move_successor(state)};
+    for (int i = 0; i < 2; i++) {
+        if (succs[i] >= 0 && dist[succs[i]] != DIST_INF
+                && dist[succs[i]] + 1u < best) {
+            best = dist[succs[i]] + 1;
+        }
+    }
+    return best;
+}
+
+/*
+ * Checks whether state still has a shortest path,
+ * i.e. it is a goal or has a successor exactly one
+ * action closer
+ */
+static int is_supported(int state) {
+    if (is_goal(state)) return dist[state] == 0;
+
+    int succs[2] = {turn_successor(state), move_successor(state)};
+    for (int i = 0; i < 2; i++) {
+        if (succs[i] >= 0 && dist[succs[i]] != DIST_INF
+                && dist[succs[i]] + 1 == dist[state]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void distfield_update(int x, int y) {
+    int seeds[MAX_SEEDS];
+    int num_seeds = 0;
+
+    // the changed cell and its neighbours may have new edges
+    const int dx[5] = {0, 1, -1, 0, 0};
+    const int dy[5] = {0, 0, 0, 1, -1};
+    for (int i = 0; i < 5; i++) {
+        int nx = x + dx[i], ny = y + dy[i];
+        if (nx < 0 || nx >= num_cols || ny < 0 || ny >= num_rows) continue;
+        for (int dir = 0; dir < 4; dir++) {
+            seeds[num_seeds++] = state_of(nx, ny, dir);
+        }
+    }
+
+    // 1. clear every state whose shortest path was cut
+    int top = 0, num_cleared = 0;
+    for (int i = 0; i < num_seeds; i++) {
+        work[top++] = seeds[i];
+    }
+    while (top > 0) {
+        int state = work[--top];
+        if (dist[state] == DIST_INF || is_supported(state)) continue;
+
+        unsigned int old = dist[state];
+        dist[state] = DIST_INF;
+        cleared[num_cleared++] = state;
+
+        // predecessors that relied on this state
+        int preds[2] = {turn_predecessor(state), move_predecessor(state)};
+        for (int i = 0; i < 2; i++) {
+            if (preds[i] >= 0 && dist[preds[i]] == old + 1) {
+                work[top++] = preds[i];
+            }
+        }
+    }
+
+    // 2. seed the repair with cleared states and the changed cells
+    heap_size = 0;
+    for (int i = 0; i < num_cleared + num_seeds; i++) {
+        int state = i < num_cleared ? cleared[i] : seeds[i - num_cleared];
+        unsigned int best = best_from_successors(state);
+        if (best < dist[state]) {
+            dist[state] = best;
+            heap_push(best << 16 | state);
+        }
+    }
+
+    // 3. propagate new distances backwards in increasing order
+    while (heap_size > 0) {
+        unsigned int key = heap_pop();
+        int state = key & 0xffff;
+        unsigned int d = key >> 16;
+        if (d != dist[state]) continue; // stale
+
+        int preds[2] = {turn_predecessor(state), move_predecessor(state)};
+        for (int i = 0; i < 2; i++) {
+            if (preds[i] >= 0 && d + 1 < dist[preds[i]]) {
+                dist[preds[i]] = d + 1;
+                heap_push((d + 1) << 16 | preds[i]);
+            }
+        }
+    }
+}
+
+int distfield_get(pos_t pos) {
+    unsigned int d = dist[state_of(pos.x, pos.y, pos.dir)];
+    return d == DIST_INF ? -1 : (int) d;
+}
+
+int distfield_next_move(pos_t pos) {
+    int state = state_of(pos.x, pos.y, pos.dir);
+    unsigned int d = dist[state];
+    if (d == DIST_INF || d == 0) return -1;
+
+    int next = move_successor(state);
+    if (next >= 0 && dist[next] + 1 == d) {
+        return MOVE_FORWARD;
+    }
+    return TURN_LEFT;
+}
@@ -0,0 +1,75 @@
+
+/*
+ * FILENAME: fixed.c
+ * ------------------------------------------------
+ * The square root works bit by bit on a 64-bit
+ * integer. atan2 folds the point into the first
+ * octant, where atan(z) for z from 0 to 1 is close
+ * to 45 z + z (1 - z) (14.02 + 3.80 z) degrees, and
+ * unfolds the result.
+ */
+
+#include "fixed.h"
+
+static fixed_t clamp(long long value) {
+    if (value > FIXED_MAX) return FIXED_MAX;
+    if (value < FIXED_MIN) return FIXED_MIN;
+    return value;
+}
+
+fixed_t fixed_div(fixed_t a, fixed_t b) {
+    if (b == 0) {
+        return a < 0 ? FIXED_MIN : FIXED_MAX;
+    }
+    return clamp(((long long) a << FIXED_SHIFT) / b);
+}
+
+fixed_t fixed_sqrt(fixed_t a) {
+    if (a <= 0) return 0;
+
+    // sqrt(a / 2^16) * 2^16 = sqrt(a * 2^16)
+    unsigned long long rest = (unsigned long long) a << FIXED_SHIFT;
+    unsigned long long root = 0;
+    unsigned long long bit = 1ULL << 62;
+
+    while (bit > rest) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (rest >= root + bit) {
+            rest -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+#define ATAN_A FIXED_FROM_INT(45)
+#define ATAN_B FIXED_FROM_RATIO(1402, 100)
+#define ATAN_C FIXED_FROM_RATIO(380, 100)
+
+// atan(z) in degrees for z from 0 to FIXED_ONE
+static fixed_t atan_octant(fixed_t z) {
+    fixed_t curve = fixed_mul(fixed_mul(z, FIXED_ONE - z), ATAN_B + fixed_mul(ATAN_C, z));
+    return fixed_mul(ATAN_A, z) + curve;
+}
+
+fixed_t fixed_atan2(fixed_t y, fixed_t x) {
+    // magnitudes as 64-bit, as -FIXED_MIN does not fit
+    long long ax = x < 0 ? -(long long) x : x;
+    long long ay = y < 0 ? -(long long) y : y;
+    if (ax == 0 && ay == 0) return 0;
+
+    fixed_t angle;
+    if (ay <= ax) {
+        angle = atan_octant((ay << FIXED_SHIFT) / ax);
+    } else {
+        angle = FIXED_FROM_INT(90) - atan_octant((ax << FIXED_SHIFT) / ay);
+    }
+
+    if (x < 0) angle = FIXED_FROM_INT(180) - angle;
+    return y < 0 ? -angle : angle;
+}
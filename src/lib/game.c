@@ -5,14 +5,125 @@
 #include "accel.h"
 #include "gl.h"
 #include "karel_world.h"
+#include "replay.h"
+#include "sched.h"
+#include "input.h"
 
 void game_init() {
-    karel_world_init(); 
     timer_init(); 
+    sched_init(timer_get_ticks, timer_idle);
+    karel_world_init(); 
 }
 
+// time each of the screens around the game is shown
+#define SCREEN_MS 4000
+
+// pacing of the game loop
+#define TICK_US 10000     // the simulation runs at 100 Hz
+#define FRAME_US KAREL_FRAME_US // the screen is redrawn at up to 60 Hz
+#define MOVE_TICKS 25     // at least 250 ms between moves
+#define MAX_CATCH_UP 5    // most ticks run in a row after a stall
+
+// time spent in one phase of the game loop, in processor cycles
+struct phase_stats {
+    unsigned int count;
+    unsigned long long total;
+    unsigned int max;
+};
+
+static struct phase_stats input_stats, sim_stats, render_stats, idle_stats;
+
+static void phase_add(struct phase_stats *stats, unsigned int cycles) {
+    stats->count++;
+    stats->total += cycles;
+    if (cycles > stats->max) {
+        stats->max = cycles;
+    }
+}
+
+// the cycle counter stops while the processor sleeps, so idle time comes from the system timer
+static void idle_add(unsigned long long start_us) {
+    phase_add(&idle_stats, (timer_get_ticks64() - start_us) * TIMER_CYCLES_PER_US);
+}
+
+static void phase_print(const char *name, const struct phase_stats *stats) {
+    unsigned int total_ms = stats->total / (TIMER_CYCLES_PER_US * 1000);
+    unsigned int average_us = stats->count ? stats->total / stats->count / TIMER_CYCLES_PER_US : 0;
+
+    printf("%s: %d runs, %d ms total, %d us average, %d us max\n", name,
+           stats->count, total_ms, average_us, stats->max / TIMER_CYCLES_PER_US);
+}
+
+/*
+ * Runs the game until Karel finds the beeper. Every
+ * time around the loop a move is taken from the
+ * sources of input (input.h), without blocking; the
+ * simulation then runs in fixed ticks and the board
+ * is redrawn at its own pace while a move is being
+ * animated or something changed.
+ * In between, the processor sleeps.
+ */
 void play_game() {
-    while (!update_karel_world()){}; 
+    unsigned int next_tick = timer_get_ticks();
+    unsigned int next_frame = next_tick;
+    int pending = -1;  // move waiting for the next tick
+    int cooldown = 0;  // ticks until the next move
+    int finished = 0;
+
+    input_stats = sim_stats = render_stats = idle_stats = (struct phase_stats) {0, 0, 0};
+    input_flush(); // moves made before the game started do not count
+
+    while (!finished) {
+
+        // 1. input; moves made meanwhile wait in their sources
+        unsigned int start = timer_get_cycles();
+        if (pending < 0) {
+            pending = input_poll();
+        }
+        phase_add(&input_stats, timer_get_cycles() - start);
+
+        // 2. simulation, catching up on ticks missed while drawing
+        int ticks = 0;
+        while (!finished && (int) (timer_get_ticks() - next_tick) >= 0) {
+            if (ticks++ == MAX_CATCH_UP) {
+                next_tick = timer_get_ticks(); // too far behind, skip ahead
+                break;
+            }
+            start = timer_get_cycles();
+            if (cooldown > 0) {
+                cooldown--;
+            } else if (pending >= 0) {
+                finished = karel_world_apply(pending) == SIM_FINISHED;
+                pending = -1;
+                cooldown = MOVE_TICKS;
+            }
+            next_tick += TICK_US;
+            phase_add(&sim_stats, timer_get_cycles() - start);
+        }
+
+        // 3. render
+        if ((int) (timer_get_ticks() - next_frame) >= 0) {
+            start = timer_get_cycles();
+            if (karel_world_draw()) {
+                phase_add(&render_stats, timer_get_cycles() - start);
+            }
+            next_frame += FRAME_US;
+            if ((int) (timer_get_ticks() - next_frame) >= 0) {
+                next_frame = timer_get_ticks() + FRAME_US; // drawing ran long
+            }
+        }
+
+        // 4. idle until the next tick or frame
+        unsigned long long idle_start = timer_get_ticks64();
+        sched_sleep_until((int) (next_frame - next_tick) < 0 ? next_frame : next_tick);
+        idle_add(idle_start);
+    }
+    karel_world_draw(); // the winning move
+
+    phase_print("input", &input_stats);
+    phase_print("simulation", &sim_stats);
+    phase_print("render", &render_stats);
+    phase_print("idle", &idle_stats);
 }
 
 void karel_adventure(void) {
@@ -24,24 +135,25 @@ void karel_adventure(void) {
         int move = MOVE_FORWARD; 
         while (move != TURN_LEFT) {
             draw_start(); 
-            move = accel_read_move(); 
+            move = input_read(); 
         }
 
         // 2. Display Rules 
         draw_rules(); 
-        timer_delay(4); 
+        sched_sleep_ms(SCREEN_MS); 
 
-        unsigned int start = timer_get_ticks();
+        unsigned long long start = timer_get_ticks64();
 
         // 3. Play Game
         play_game(); 
 
-        unsigned int time_taken_s = (timer_get_ticks() - start) / 1000000;
+        unsigned int time_taken_s = (timer_get_ticks64() - start) / 1000000;
+        replay_dump(); // so the session can be replayed later
 
         // 4. Resume Screen 
         draw_resume(time_taken_s);
-        timer_delay(4);
-        move = accel_read_move(); 
+        sched_sleep_ms(SCREEN_MS);
+        move = input_read(); 
 
         if (move == MOVE_FORWARD) {
             break; 
@@ -49,6 +161,6 @@ void karel_adventure(void) {
     }
 
     draw_end();
-    timer_delay(4);
+    sched_sleep_ms(SCREEN_MS);
 }
 
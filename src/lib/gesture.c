@@ -0,0 +1,167 @@
+
+/*
+ * FILENAME: gesture.c
+ * ------------------------------------------------
+ * Samples are turned into degrees per second in
+ * fixed point (see fixed.h), and the tilt and the
+ * turn are kept in degrees that way, so each sample
+ * costs a few multiplications, two fixed_atan2 calls
+ * and no float arithmetic.
+ *
+ * The tilt comes from a complementary filter: the
+ * gyroscope's x and y rates are added up, which
+ * follows a tilt at once but drifts, and each sample
+ * pulls the result a little toward the angle of
+ * gravity the accelerometer sees, which does not
+ * drift but jumps with every knock.
+ */
+
+#include "gesture.h"
+#include "accel.h"
+#include "fixed.h"
+
+// sensor ranges set by LSM6DS33.c: +-2 g and 245 dps
+#define DPS_PER_COUNT   FIXED_FROM_RATIO(875, 100000)
+
+// degrees of tilt for one count of accelerometer noise at 1 g (180 / pi / 16384)
+#define DEGREES_PER_COUNT FIXED_FROM_RATIO(35, 10000)
+
+// the board tilted: this many degrees from flat either way, until back within exit
+#define TILT_ENTER_DEGREES 40
+#define TILT_EXIT_DEGREES  25
+
+// a turn: most of a quarter turn while the gyroscope keeps spinning
+#define TURN_DEGREES  68
+#define SPIN_DPS      30   // slower counts as holding still
+#define STILL_MS      60   // holding still this long ends a turn
+
+// no move is reported this long after one; a held tilt steps this often
+#define REFRACTORY_MS 150
+#define REPEAT_MS     400
+
+// on noisy boards thresholds are kept this many standard deviations from rest
+#define SPIN_SIGMAS       5
+#define TILT_ENTER_SIGMAS 6
+#define TILT_EXIT_SIGMAS  3
+
+// complementary filter: each sample pulls the gyroscope's angles this part of
+// the way toward the accelerometer's, about half a second's time constant at 104 Hz
+#define ACCEL_WEIGHT FIXED_FROM_RATIO(1, 50)
+
+// what the sensor reads at rest, and thresholds that allow for its noise
+static int gyro_bias[3], accel_bias[3]; // in counts
+static fixed_t spin_threshold;          // in dps
+static fixed_t tilt_enter, tilt_exit;   // in degrees
+
+// time between samples, and times in samples
+static fixed_t dt;
+static int still_samples;
+static int refractory_samples, repeat_samples;
+
+static int primed;      // pitch and roll hold a sample
+static fixed_t pitch;   // tilt about y, in degrees
+static fixed_t roll;    // tilt about x, in degrees
+static fixed_t turn;    // gyroscope z added up, in degrees
+static int still;       // samples since the gyroscope last spun
+static int tilted;      // a tilt is being held
+static int quiet;       // samples until another move may be reported
+static int repeat;      // samples until a held tilt steps again
+
+static int ms_to_samples(int ms, int rate_hz) {
+    int samples = ms * rate_hz / 1000;
+    return samples > 0 ? samples : 1;
+}
+
+void gesture_init(int rate_hz) {
+    dt = FIXED_FROM_RATIO(1, rate_hz);
+    still_samples = ms_to_samples(STILL_MS, rate_hz);
+    refractory_samples = ms_to_samples(REFRACTORY_MS, rate_hz);
+    repeat_samples = ms_to_samples(REPEAT_MS, rate_hz);
+
+    calibration_t none = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+    gesture_calibrate(&none);
+
+    primed = 0;
+    turn = still = tilted = quiet = repeat = 0;
+}
+
+static fixed_t larger(fixed_t a, fixed_t b) {
+    return a > b ? a : b;
+}
+
+static fixed_t magnitude(fixed_t a) {
+    return a < 0 ? -a : a;
+}
+
+void gesture_calibrate(const calibration_t *cal) {
+    for (int axis = 0; axis < 3; axis++) {
+        gyro_bias[axis] = cal->gyro_bias[axis];
+        accel_bias[axis] = cal->accel_bias[axis];
+    }
+
+    spin_threshold = larger(FIXED_FROM_INT(SPIN_DPS),
+                            SPIN_SIGMAS * cal->gyro_noise[2] * DPS_PER_COUNT);
+    fixed_t noise = larger(cal->accel_noise[0], cal->accel_noise[1]) * DEGREES_PER_COUNT;
+    tilt_enter = larger(FIXED_FROM_INT(TILT_ENTER_DEGREES), TILT_ENTER_SIGMAS * noise);
+    tilt_exit = larger(FIXED_FROM_INT(TILT_EXIT_DEGREES), TILT_EXIT_SIGMAS * noise);
+}
+
+/*
+ * One step of the complementary filter: angle moves
+ * by the gyroscope's rate, then part of the way to
+ * the accelerometer's angle
+ */
+static fixed_t fuse(fixed_t angle, int rate, fixed_t measured) {
+    angle += fixed_mul(rate * DPS_PER_COUNT, dt);
+    return angle + fixed_mul(ACCEL_WEIGHT, measured - angle);
+}
+
+int gesture_feed(const sensor_sample_t *sample) {
+    // gravity's angle: tilting by a positive pitch moves it toward -x, by a roll toward +y
+    int x = sample->accel[0] - accel_bias[0];
+    int y = sample->accel[1] - accel_bias[1];
+    int z = sample->accel[2] - accel_bias[2];
+    fixed_t accel_pitch = fixed_atan2(-x, z);
+    fixed_t accel_roll = fixed_atan2(y, z);
+    if (!primed) {
+        pitch = accel_pitch;
+        roll = accel_roll;
+        primed = 1;
+    } else {
+        pitch = fuse(pitch, sample->gyro[1] - gyro_bias[1], accel_pitch);
+        roll = fuse(roll, sample->gyro[0] - gyro_bias[0], accel_roll);
+    }
+    fixed_t tilt = larger(magnitude(pitch), magnitude(roll));
+
+    // add up the turn while the gyroscope spins; holding still ends it
+    fixed_t spin = (sample->gyro[2] - gyro_bias[2]) * DPS_PER_COUNT;
+    if (spin > spin_threshold || spin < -spin_threshold) {
+        still = 0;
+    } else if (still < still_samples) {
+        still++;
+    }
+    turn = still == still_samples ? 0 : fixed_add_sat(turn, fixed_mul(spin, dt));
+
+    if (!tilted && tilt > tilt_enter) {
+        tilted = 1;
+        repeat = 0;
+    } else if (tilted && tilt < tilt_exit) {
+        tilted = 0;
+    }
+
+    if (quiet > 0) quiet--;
+    if (repeat > 0) repeat--;
+
+    int move = -1;
+    if (quiet == 0 && turn >= FIXED_FROM_INT(TURN_DEGREES)) {
+        move = TURN_LEFT;
+        turn -= FIXED_FROM_INT(90); // turning on counts toward the next quarter
+    } else if (quiet == 0 && tilted && repeat == 0) {
+        move = MOVE_FORWARD;
+        repeat = repeat_samples;
+    }
+    if (move >= 0) {
+        quiet = refractory_samples;
+    }
+    return move;
+}
@@ -16,6 +16,7 @@
 #include "strings.h"
 #include "font.h"
 #include "printf.h"
+#include "fixed.h"
  
 
 // format used is ARGB, with A (Opacity) as the most significant
@@ -170,42 +171,42 @@ unsigned int gl_get_char_width(void)
  * colour of choice's value at that channel.
  * 
  * @params  current color (color_t), channel shift (unsigned int), 
- *          percent (float)
+ *          percent (fixed_t, see fixed.h)
  * @returns intermediate value (int)
  * @precon  channel shift must be of RED, BLUE or GREEN
- *          percent <= 1
+ *          0 <= percent <= FIXED_ONE
  */
-unsigned char blend_channel(color_t c1, int shift, float percent)
+unsigned char blend_channel(color_t c1, int shift, fixed_t percent)
 {
     // bitwise operations to get that colour channel
     int channel1 = (c1 >> shift) & 0xff;
     int channel2 = (background >> shift) & 0xff;
 
-    return channel1 + (channel2 - channel1) * percent;
+    return channel1 + FIXED_TO_INT((channel2 - channel1) * percent);
 }
 
 void gl_draw_line(int x1, int y1, int x2, int y2, color_t c) {
-    float m = (y2 - y1) / (float) (x2 - x1); // gradient
-
     // determine ranges to draw the line
     int min_x = x1;
     int max_x = x2;
-    float offset = y1 - m * x1;
 
     if (x1 > x2) {
         min_x = x2;
         max_x = x1;
     }
+    if (min_x == max_x) return; // vertical, nothing drawn
+
+    // gradient, and y at the first x; y then moves by the gradient each step
+    fixed_t m = fixed_div(FIXED_FROM_INT(y2 - y1), FIXED_FROM_INT(x2 - x1));
+    fixed_t y = FIXED_FROM_INT(y1) + m * (min_x - x1);
 
     // for each x value
-    for (int x = min_x; x < max_x; x++) {
+    for (int x = min_x; x < max_x; x++, y += m) {
 
-        // calculate y value
-        float y = m * x + offset; // y = mx + c
-        int truncated_y = (int) y;
+        int truncated_y = FIXED_TO_INT(y);
 
         // calculate intensity of each pixel
-        float intensity_upper = y - truncated_y;
+        fixed_t intensity_upper = FIXED_FRAC(y);
 
         // isolate colours
         unsigned char blue = blend_channel(c, BLUE_SHIFT, intensity_upper);
@@ -245,3 +246,27 @@ void gl_draw_image(const unsigned char ref_img[], int width, int height, int x,
     }
 } 
 
+void gl_draw_image_rotated(const unsigned char ref_img[], int width, int height,
+                           int x, int y, int sin_q12, int cos_q12) {
+    int cx = width / 2;
+    int cy = height / 2;
+
+    for (int row = 0; row < height; row++) {
+        for (int col = 0; col < width; col++) {
+
+            // turn each drawn pixel back to find where it comes from
+            int dx = col - cx;
+            int dy = row - cy;
+            int src_x = cx + ((dx * cos_q12 - dy * sin_q12 + 2048) >> 12);
+            int src_y = cy + ((dx * sin_q12 + dy * cos_q12 + 2048) >> 12);
+            if (src_x < 0 || src_x >= width || src_y < 0 || src_y >= height) {
+                continue;
+            }
+
+            color_t color = get_pixel_color(ref_img, (src_y * width + src_x) * 3);
+            if (color != GL_WHITE) {
+                gl_draw_pixel(x + col, y + row, color);
+            }
+        }
+    }
+}
@@ -9,6 +9,7 @@
 
 #include "gpio.h"
 #include "i2c.h"
+#include "interrupts.h"
 #include "timer.h"
 
 
@@ -26,6 +27,9 @@ struct I2C { // I2C registers
 #define	CONTROL_READ				0x0001
 #define CONTROL_CLEAR_FIFO	0x0010
 #define CONTROL_START				0x0080
+#define CONTROL_INTERRUPT_DONE	0x0100
+#define CONTROL_INTERRUPT_WRITE	0x0200
+#define CONTROL_INTERRUPT_READ	0x0400
 #define CONTROL_ENABLE			0x8000
 
 #define STATUS_TRANSFER_ACTIVE	0x001
@@ -55,71 +59,122 @@ struct I2C { // I2C registers
 #define SCL GPIO_PIN3
 #define BSC_BASE 0x20804000
 
+// BSC clocks are divided down from the core clock
+#define CORE_CLOCK_HZ 250000000
+
+// a transfer may take this long, plus time for its bytes
+#define POLL_SLACK_US 1000
+
 static volatile struct I2C *i2c = (struct I2C *) BSC_BASE;
 
-// #define SHORT_DELAY 50
-#define NORM_DELAY 500
+// the transfers waiting, the first of which is on the bus
+static i2c_xfer_t *queue[I2C_QUEUE_SIZE];
+static volatile unsigned int queue_head;
+static volatile unsigned int queue_tail;
+static int use_interrupts;
+
+// progress of the transfer on the bus
+static int reading;         // in the read part
+static int part_index;      // bytes of that part moved
+static volatile unsigned int started; // when it started, in us
+
+static unsigned int us_per_byte; // 9 clocks, rounded up
+static unsigned int latencies[I2C_LATENCY_BUCKETS];
+
+void i2c_set_clock(unsigned int hz) {
+    i2c->clock_divider = (CORE_CLOCK_HZ / hz) & ~1; // must be even
+    us_per_byte = (9 * 1000000 + hz - 1) / hz;
+}
 
 void i2c_init(void) {
     gpio_set_function(SDA, GPIO_FUNC_ALT0);
     gpio_set_function(SCL, GPIO_FUNC_ALT0);
     i2c->control = CONTROL_ENABLE;
+    i2c_set_clock(I2C_STANDARD_HZ);
+    i2c_latency_reset();
+}
+
+static void record_latency(unsigned int us) {
+    int bucket = 0;
+    while (us > 1 && bucket < I2C_LATENCY_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    latencies[bucket]++;
+}
+
+void i2c_latency_histogram(unsigned int counts[I2C_LATENCY_BUCKETS]) {
+    for (int i = 0; i < I2C_LATENCY_BUCKETS; i++) {
+        counts[i] = latencies[i];
+    }
+}
+
+void i2c_latency_reset(void) {
+    for (int i = 0; i < I2C_LATENCY_BUCKETS; i++) {
+        latencies[i] = 0;
+    }
 }
 
-void i2c_read(unsigned peripheral_address, char *data, int data_length) {
-    // clear out the FIFO
+// empties the FIFO, clears the last transfer's flags and sets up the next
+static void prepare(unsigned peripheral_address, int data_length) {
     i2c->control |= CONTROL_CLEAR_FIFO;
     while (!(i2c->status & STATUS_FIFO_EMPTY))
         ;
-    // clear previous transfer's flags
     i2c->status |= STATUS_TRANSFER_DONE |
                    STATUS_ERROR_PERIPHERAL_ACK |
                    STATUS_TIMEOUT;
 
-    // set peripheral address + data length
     i2c->peripheral_address = peripheral_address;
     i2c->data_length = data_length;
+}
+
+static int result(unsigned int status, int moved, int data_length) {
+    if (status & STATUS_ERROR_PERIPHERAL_ACK) return I2C_NACK;
+    if (status & STATUS_TIMEOUT) return I2C_CLOCK_TIMEOUT;
+    if (moved < data_length) return I2C_INCOMPLETE;
+    return I2C_OK;
+}
+
+// longest a transfer of data_length bytes may take
+static unsigned int poll_timeout(int data_length) {
+    return POLL_SLACK_US + (data_length + 1) * us_per_byte;
+}
+
+// stops a transfer that is taking too long
+static int give_up(void) {
+    i2c->control = CONTROL_ENABLE | CONTROL_CLEAR_FIFO;
+    return I2C_TIMEOUT;
+}
+
+static int polled_read(unsigned peripheral_address, unsigned char *data, int data_length) {
+    prepare(peripheral_address, data_length);
     int data_index = 0;
+    unsigned int start = timer_get_ticks();
+    unsigned int timeout = poll_timeout(data_length);
 
     // begin read
     i2c->control |= CONTROL_READ | CONTROL_START;
 
-    timer_delay_us(NORM_DELAY);
-    // keep reading until transfer is complete
-    while ((i2c->status & STATUS_FIFO_CAN_READ) &&
-            (!(i2c->status & STATUS_TRANSFER_DONE) ||
-             (data_index < data_length))) {
-        timer_delay_us(40);
-        data[data_index++] = i2c->data_fifo;
-    }
-#if 0
-    // inform end user of potential responses
-    if (i2c->status & STATUS_ERROR_PERIPHERAL_ACK) {
-        printf("NACK received.\n");
-    }
-    if (i2c->status & STATUS_TIMEOUT) {
-        printf("Clock timed out.\n");
+    // take each byte as it arrives, until the transfer is over
+    while (1) {
+        int status = i2c->status;
+        if ((status & STATUS_FIFO_CAN_READ) && data_index < data_length) {
+            data[data_index++] = i2c->data_fifo;
+        } else if (status & STATUS_TRANSFER_DONE) {
+            break;
+        } else if (timer_get_ticks() - start > timeout) {
+            return give_up();
+        }
     }
-    if (data_index < data_length) {
-        printf("Data transfer incomplete.\n");
-    }
-#endif
+    record_latency(timer_get_ticks() - start);
+    return result(i2c->status, data_index, data_length);
 }
 
-void i2c_write(unsigned peripheral_address, char *data, int data_length) {
-    // clear out the FIFO
-    i2c->control |= CONTROL_CLEAR_FIFO;
-    while (!(i2c->status & STATUS_FIFO_EMPTY))
-        ;
-    // clear previous transfer's flags
-    i2c->status |= STATUS_TRANSFER_DONE |
-                   STATUS_ERROR_PERIPHERAL_ACK |
-                   STATUS_TIMEOUT;
-
-    // set peripheral address + data length
-    i2c->peripheral_address = peripheral_address;
-    i2c->data_length = data_length;
+static int polled_write(unsigned peripheral_address, const unsigned char *data, int data_length) {
+    prepare(peripheral_address, data_length);
     int data_index = 0;
+    unsigned int start = timer_get_ticks();
+    unsigned int timeout = poll_timeout(data_length);
 
     // write first 16 chunks into FIFO
     while ((data_index < FIFO_MAX_SIZE) &&
@@ -132,25 +187,178 @@ void i2c_write(unsigned peripheral_address, char *data, int data_length) {
     i2c->control |= CONTROL_START;
 
     // as fifo clears up, continue transferring until done
-    while (!(i2c->status & STATUS_TRANSFER_DONE) &&
-            (i2c->status & STATUS_FIFO_CAN_WRITE) &&
-            (data_index < data_length)) {
-        i2c->data_fifo = data[data_index++];
+    while (!(i2c->status & STATUS_TRANSFER_DONE)) {
+        if ((i2c->status & STATUS_FIFO_CAN_WRITE) && data_index < data_length) {
+            i2c->data_fifo = data[data_index++];
+        } else if (timer_get_ticks() - start > timeout) {
+            return give_up();
+        }
     }
+    record_latency(timer_get_ticks() - start);
+    return result(i2c->status, data_index, data_length);
+}
 
-    // wait until the FIFO's contents are emptied by the peripheral
-    while (!(i2c->status & STATUS_FIFO_EMPTY))
-        ;
-#if 0
-    // inform end user of potential responses
-    if (i2c->status & STATUS_ERROR_PERIPHERAL_ACK) {
-        printf("NACK received.\n");
+// starts the write or read part of the first transfer in the queue
+static void start_part(void) {
+    i2c_xfer_t *xfer = queue[queue_head % I2C_QUEUE_SIZE];
+    part_index = 0;
+
+    if (!reading) {
+        prepare(xfer->address, xfer->write_len);
+        while (part_index < FIFO_MAX_SIZE && part_index < xfer->write_len) {
+            i2c->data_fifo = xfer->write[part_index++];
+        }
+        int more = part_index < xfer->write_len ? CONTROL_INTERRUPT_WRITE : 0;
+        i2c->control = CONTROL_ENABLE | CONTROL_INTERRUPT_DONE | more | CONTROL_START;
+    } else {
+        prepare(xfer->address, xfer->read_len);
+        i2c->control = CONTROL_ENABLE | CONTROL_INTERRUPT_DONE | CONTROL_INTERRUPT_READ
+                       | CONTROL_START | CONTROL_READ;
+    }
+}
+
+static void start_next(void) {
+    if (queue_head != queue_tail) {
+        reading = queue[queue_head % I2C_QUEUE_SIZE]->write_len == 0;
+        started = timer_get_ticks();
+        start_part();
+    }
+}
+
+// takes the first transfer off the queue, starts the next and reports
+static void finish(int status) {
+    i2c_xfer_t *xfer = queue[queue_head % I2C_QUEUE_SIZE];
+    record_latency(timer_get_ticks() - started);
+    queue_head++;
+    start_next();
+    if (xfer->done) {
+        xfer->done(status, xfer->aux);
+    }
+}
+
+static void i2c_interrupt(unsigned int pc, void *aux_data) {
+    if (queue_head == queue_tail) return;
+
+    i2c_xfer_t *xfer = queue[queue_head % I2C_QUEUE_SIZE];
+    unsigned int status = i2c->status;
+
+    // move what the FIFO can take or give
+    if (reading) {
+        while ((i2c->status & STATUS_FIFO_CAN_READ) && part_index < xfer->read_len) {
+            xfer->read[part_index++] = i2c->data_fifo;
+        }
+    } else {
+        while ((i2c->status & STATUS_FIFO_CAN_WRITE) && part_index < xfer->write_len) {
+            i2c->data_fifo = xfer->write[part_index++];
+        }
+        if (part_index == xfer->write_len) {
+            i2c->control &= ~CONTROL_INTERRUPT_WRITE;
+        }
     }
-    if (i2c->status & STATUS_TIMEOUT) {
-        printf("Clock timed out.\n");
+
+    if (!(status & STATUS_TRANSFER_DONE)) return;
+
+    int moved = part_index;
+    int outcome = result(status, moved, reading ? xfer->read_len : xfer->write_len);
+    i2c->status = STATUS_TRANSFER_DONE | STATUS_ERROR_PERIPHERAL_ACK | STATUS_TIMEOUT;
+
+    if (outcome == I2C_OK && !reading && xfer->read_len > 0) {
+        reading = 1;
+        start_part();
+    } else {
+        i2c->control = CONTROL_ENABLE; // no more interrupts until the next start
+        finish(outcome);
     }
-    if (data_index < data_length) {
-        printf("Data transfer incomplete.\n");
+}
+
+void i2c_interrupts_enable(void) {
+    interrupts_register_handler(INTERRUPTS_VC_I2C, i2c_interrupt, NULL);
+    interrupts_enable_source(INTERRUPTS_VC_I2C);
+    use_interrupts = 1;
+}
+
+int i2c_submit(i2c_xfer_t *xfer) {
+    if (!use_interrupts) {
+        int status = I2C_OK;
+        if (xfer->write_len > 0) {
+            status = polled_write(xfer->address, xfer->write, xfer->write_len);
+        }
+        if (status == I2C_OK && xfer->read_len > 0) {
+            status = polled_read(xfer->address, xfer->read, xfer->read_len);
+        }
+        if (xfer->done) {
+            xfer->done(status, xfer->aux);
+        }
+        return 1;
+    }
+
+    // keep the interrupt from changing the queue meanwhile
+    interrupts_disable_source(INTERRUPTS_VC_I2C);
+    int queued = queue_tail - queue_head < I2C_QUEUE_SIZE;
+    if (queued) {
+        queue[queue_tail % I2C_QUEUE_SIZE] = xfer;
+        queue_tail++;
+        if (queue_tail - queue_head == 1) {
+            start_next(); // the bus was free
+        }
+    }
+    interrupts_enable_source(INTERRUPTS_VC_I2C);
+    return queued;
+}
+
+// where a waited-for transfer leaves its status
+typedef struct {
+    volatile int done;
+    volatile int status;
+} waiter_t;
+
+static void mark_done(int status, void *aux) {
+    waiter_t *waiter = aux;
+    waiter->status = status;
+    waiter->done = 1;
+}
+
+// a lost DONE interrupt or a stuck bus would otherwise keep the
+// transfer, and everything queued behind it, there for good
+void i2c_check_timeouts(void) {
+    if (!use_interrupts) return; // polled transfers time themselves out
+
+    interrupts_disable_source(INTERRUPTS_VC_I2C);
+    if (queue_head != queue_tail) {
+        i2c_xfer_t *xfer = queue[queue_head % I2C_QUEUE_SIZE];
+        if (timer_get_ticks() - started > poll_timeout(xfer->write_len + xfer->read_len)) {
+            give_up();
+            finish(I2C_TIMEOUT);
+        }
+    }
+    interrupts_enable_source(INTERRUPTS_VC_I2C);
+}
+
+int i2c_transfer(i2c_xfer_t *xfer) {
+    waiter_t waiter = {0, I2C_OK};
+    xfer->done = mark_done;
+    xfer->aux = &waiter;
+    while (!i2c_submit(xfer)) {
+        i2c_check_timeouts(); // the queue is full
+    }
+    while (!waiter.done) {
+        i2c_check_timeouts();
+    }
+    return waiter.status;
+}
+
+int i2c_read(unsigned peripheral_address, char *data, int data_length) {
+    if (!use_interrupts) {
+        return polled_read(peripheral_address, (unsigned char *) data, data_length);
+    }
+    i2c_xfer_t xfer = {peripheral_address, 0, 0, (unsigned char *) data, data_length};
+    return i2c_transfer(&xfer);
+}
+
+int i2c_write(unsigned peripheral_address, char *data, int data_length) {
+    if (!use_interrupts) {
+        return polled_write(peripheral_address, (unsigned char *) data, data_length);
     }
-#endif
+    i2c_xfer_t xfer = {peripheral_address, (unsigned char *) data, data_length};
+    return i2c_transfer(&xfer);
 }
@@ -0,0 +1,78 @@
+
+/*
+ * FILENAME: input.c
+ * ------------------------------------------------
+ * The sources in use are kept in a small array. next
+ * is the one polled first, and after a move it is the
+ * source after the one that gave it.
+ */
+
+#include "input.h"
+
+static const input_source_t *sources[INPUT_MAX_SOURCES];
+static int nsources;
+static int next;
+
+// the script being played back
+static const unsigned char *script;
+static int script_len;
+static int script_pos;
+
+void input_init(void) {
+    nsources = 0;
+    next = 0;
+}
+
+int input_add(const input_source_t *source) {
+    if (nsources == INPUT_MAX_SOURCES) {
+        return 0;
+    }
+    if (source->init && !source->init()) {
+        return 0;
+    }
+    sources[nsources++] = source;
+    return 1;
+}
+
+int input_poll(void) {
+    for (int i = 0; i < nsources; i++) {
+        int source = (next + i) % nsources;
+        int move = sources[source]->poll();
+        if (move >= 0) {
+            next = (source + 1) % nsources;
+            return move;
+        }
+    }
+    return -1;
+}
+
+int input_read(void) {
+    int move;
+
+    while ((move = input_poll()) < 0) {}
+    return move;
+}
+
+void input_flush(void) {
+    for (int i = 0; i < nsources; i++) {
+        if (sources[i]->flush) {
+            sources[i]->flush();
+        }
+    }
+}
+
+void input_script_load(const unsigned char *moves, int n) {
+    script = moves;
+    script_len = n;
+    script_pos = 0;
+}
+
+int input_script_left(void) {
+    return script_len - script_pos;
+}
+
+static int script_poll(void) {
+    return script_pos < script_len ? script[script_pos++] : -1;
+}
+
+const input_source_t input_script = {"script", 0, script_poll, 0};
@@ -0,0 +1,219 @@
+
+/*
+ * FILENAME: journal.c
+ * ------------------------------------------------
+ * Keeps Karel's moves as 2-bit codes packed into
+ * words, lowest bits first. Undoing a forward move
+ * steps back against Karel's direction and undoing
+ * a turn turns the other way, so undo never needs
+ * the board. Picks and puts share a code and note
+ * which they were, and the cell they happened in, so
+ * jumps can put beepers back without walking every
+ * move in between.
+ */
+
+#include "journal.h"
+#include "board.h"
+#include "tiles.h"
+#include "accel.h"
+
+#define CODES_PER_WORD 16
+#define NUM_WORDS (JOURNAL_MAX_STEPS / CODES_PER_WORD)
+#define NUM_SNAPSHOTS (JOURNAL_MAX_STEPS / JOURNAL_SNAPSHOT_EVERY + 1)
+
+// 2-bit move codes
+#define CODE_FORWARD 0
+#define CODE_LEFT    1
+#define CODE_BEEPER  2 // a pick or put, see beeper_ops
+#define CODE_RIGHT   3
+
+// a pick or put, and where it happened
+struct beeper_op {
+    int step;
+    short x, y;
+    short pick; // 1 for a pick, 0 for a put
+};
+
+static unsigned int codes[NUM_WORDS];
+static pos_t snapshots[NUM_SNAPSHOTS]; // position at every Nth step
+static struct beeper_op beeper_ops[JOURNAL_MAX_BEEPER_OPS];
+static int num_beeper_ops;
+static int cur;    // moves made
+static int length; // moves made or undone
+
+static inline int get_code(int step) {
+    return (codes[step / CODES_PER_WORD] >> (step % CODES_PER_WORD * 2)) & 0x3;
+}
+
+static inline void set_code(int step, int code) {
+    int shift = step % CODES_PER_WORD * 2;
+    unsigned int *word = &codes[step / CODES_PER_WORD];
+    *word = (*word & ~(0x3u << shift)) | (unsigned int) code << shift;
+}
+
+// moves pos forward over a move; picks and puts stay put
+static void forward(pos_t *pos, int code) {
+    if (code == CODE_LEFT) {
+        pos->dir = (pos->dir + 1) % 4;
+    } else if (code == CODE_RIGHT) {
+        pos->dir = (pos->dir + 3) % 4;
+    } else if (code == CODE_FORWARD) {
+        pos->x += (pos->dir == EAST) - (pos->dir == WEST);
+        pos->y += (pos->dir == SOUTH) - (pos->dir == NORTH);
+    }
+}
+
+static void backward(pos_t *pos, int code) {
+    if (code == CODE_LEFT) {
+        pos->dir = (pos->dir + 3) % 4;
+    } else if (code == CODE_RIGHT) {
+        pos->dir = (pos->dir + 1) % 4;
+    } else if (code == CODE_FORWARD) {
+        pos->x -= (pos->dir == EAST) - (pos->dir == WEST);
+        pos->y -= (pos->dir == SOUTH) - (pos->dir == NORTH);
+    }
+}
+
+// makes a pick or put again, or takes it back
+static void redo_beeper(int pick, int x, int y) {
+    int bag = karel_sim_bag();
+    if (pick) {
+        tiles_remove_beeper(x, y);
+        karel_sim_set_bag(bag + 1);
+    } else {
+        tiles_add_beeper(x, y);
+        karel_sim_set_bag(bag - 1);
+    }
+}
+
+static void undo_beeper(int pick, int x, int y) {
+    redo_beeper(!pick, x, y);
+}
+
+// first beeper op at or after step
+static int first_beeper_op(int step) {
+    int lo = 0, hi = num_beeper_ops;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (beeper_ops[mid].step < step) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+void journal_init(pos_t start) {
+    cur = length = num_beeper_ops = 0;
+    snapshots[0] = start;
+}
+
+int journal_push(int move) {
+    static const int code_for[] = {
+        [MOVE_FORWARD] = CODE_FORWARD + 1,
+        [TURN_LEFT] = CODE_LEFT + 1,
+        [TURN_RIGHT] = CODE_RIGHT + 1,
+        [PICK_BEEPER] = CODE_BEEPER + 1,
+        [PUT_BEEPER] = CODE_BEEPER + 1,
+    };
+    if (move < 0 || move > PUT_BEEPER || !code_for[move]) {
+        return 0;
+    }
+    int code = code_for[move] - 1;
+    int is_beeper_op = code == CODE_BEEPER;
+
+    // forget the picks and puts that could have been redone
+    num_beeper_ops = first_beeper_op(cur);
+
+    // when full, start over so undo never goes past a lost move
+    if (cur == JOURNAL_MAX_STEPS
+        || (is_beeper_op && num_beeper_ops == JOURNAL_MAX_BEEPER_OPS)) {
+        journal_init(karel_sim_position());
+        return 0;
+    }
+
+    if (is_beeper_op) {
+        pos_t karel = karel_sim_position();
+        beeper_ops[num_beeper_ops++] = (struct beeper_op) {cur, karel.x, karel.y, move == PICK_BEEPER};
+    }
+
+    set_code(cur, code);
+    length = ++cur;
+
+    if (cur % JOURNAL_SNAPSHOT_EVERY == 0) {
+        snapshots[cur / JOURNAL_SNAPSHOT_EVERY] = karel_sim_position();
+    }
+    return 1;
+}
+
+int journal_undo(void) {
+    static const int inverse[] = {
+        [CODE_FORWARD] = MOVE_BACKWARD,
+        [CODE_LEFT] = TURN_RIGHT,
+        [CODE_RIGHT] = TURN_LEFT,
+    };
+    if (cur == 0) return -1;
+
+    pos_t karel = karel_sim_position();
+    int code = get_code(--cur);
+    if (code == CODE_BEEPER) {
+        const struct beeper_op *op = &beeper_ops[first_beeper_op(cur)];
+        undo_beeper(op->pick, op->x, op->y);
+        return op->pick ? PUT_BEEPER : PICK_BEEPER;
+    }
+    backward(&karel, code);
+    karel_sim_init(karel);
+    return inverse[code];
+}
+
+int journal_redo(void) {
+    static const int move_for[] = {
+        [CODE_FORWARD] = MOVE_FORWARD,
+        [CODE_LEFT] = TURN_LEFT,
+        [CODE_RIGHT] = TURN_RIGHT,
+    };
+    if (cur == length) return -1;
+
+    pos_t karel = karel_sim_position();
+    int code = get_code(cur++);
+    if (code == CODE_BEEPER) {
+        const struct beeper_op *op = &beeper_ops[first_beeper_op(cur - 1)];
+        redo_beeper(op->pick, op->x, op->y);
+        return op->pick ? PICK_BEEPER : PUT_BEEPER;
+    }
+    forward(&karel, code);
+    karel_sim_init(karel);
+    return move_for[code];
+}
+
+int journal_goto(int step) {
+    if (step < 0 || step > length) return 0;
+
+    // picks and puts between here and there, newest first when going back
+    if (step < cur) {
+        for (int i = first_beeper_op(cur) - 1; i >= 0 && beeper_ops[i].step >= step; i--) {
+            undo_beeper(beeper_ops[i].pick, beeper_ops[i].x, beeper_ops[i].y);
+        }
+    } else {
+        for (int i = first_beeper_op(cur); i < num_beeper_ops && beeper_ops[i].step < step; i++) {
+            redo_beeper(beeper_ops[i].pick, beeper_ops[i].x, beeper_ops[i].y);
+        }
+    }
+
+    // replay from the snapshot before step
+    int from = step / JOURNAL_SNAPSHOT_EVERY * JOURNAL_SNAPSHOT_EVERY;
+    pos_t karel = snapshots[from / JOURNAL_SNAPSHOT_EVERY];
+    for (int i = from; i < step; i++) {
+        forward(&karel, get_code(i));
+    }
+
+    karel_sim_init(karel);
+    cur = step;
+    return 1;
+}
+
+int journal_step(void) {
+    return cur;
+}
+
+int journal_length(void) {
+    return length;
+}
@@ -0,0 +1,383 @@
+
+/*
+ * FILENAME: karel_compile.c
+ * ------------------------------------------------
+ * Compiles the Karel language described in
+ * karel_vm.h into bytecode, with a small recursive
+ * descent parser that emits code as it goes.
+ *
+ * Each program is compiled after the functions kept
+ * from earlier programs. A program that defines
+ * functions is kept as well (its own statements
+ * are simply never run again); other programs are
+ * overwritten by the next compile.
+ */
+
+#include "karel_vm.h"
+#include "strings.h"
+#include "printf.h"
+
+#define MAX_TOKEN 23
+#define MAX_FUNCS 32
+#define MAX_FIXUPS 64
+#define MAX_NESTING 16
+
+struct func {
+    char name[MAX_TOKEN + 1];
+    unsigned short addr;
+};
+
+// call to a function that is not defined yet
+struct fixup {
+    char name[MAX_TOKEN + 1];
+    unsigned short at;
+};
+
+static unsigned char code[KAREL_CODE_SIZE];
+static int kept_end; // end of code kept from earlier programs
+static int pc;       // where the next byte is emitted
+
+static struct func funcs[MAX_FUNCS];
+static int num_funcs;
+static struct fixup fixups[MAX_FIXUPS];
+static int num_fixups;
+
+static const char *src;
+static char token[MAX_TOKEN + 1];
+static int nesting;
+static int defined_func;
+
+static const char *error;
+static char error_buf[64];
+
+static const char *const keywords[] = {
+    "def", "repeat", "while", "if", "else", "not",
+    "move", "turn_left", "pick_beeper", "put_beeper",
+};
+
+static const struct {
+    const char *name;
+    unsigned char cond;
+} predicates[] = {
+    {"front_is_clear", COND_FRONT_CLEAR},
+    {"front_is_blocked", COND_FRONT_CLEAR | COND_NOT},
+    {"beepers_present", COND_BEEPERS_PRESENT},
+    {"no_beepers_present", COND_BEEPERS_PRESENT | COND_NOT},
+    {"facing_east", COND_FACING_EAST},
+    {"facing_north", COND_FACING_NORTH},
+    {"facing_west", COND_FACING_WEST},
+    {"facing_south", COND_FACING_SOUTH},
+};
+
+#define COUNT(array) ((int) (sizeof(array) / sizeof((array)[0])))
+
+static void fail(const char *message, const char *detail) {
+    if (!error) {
+        snprintf(error_buf, sizeof(error_buf), message, detail);
+        error = error_buf;
+    }
+}
+
+static int is_word_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+        || (c >= '0' && c <= '9') || c == '_';
+}
+
+/*
+ * Reads the next token into `token`. Tokens are words,
+ * numbers, '{' and '}'; an empty token marks the end.
+ */
+static void advance(void) {
+    while (*src == ' ' || *src == '\t' || *src == '\n' || *src == ';') {
+        src++;
+    }
+
+    int len = 0;
+    if (*src == '{' || *src == '}') {
+        token[len++] = *src++;
+    } else if (is_word_char(*src)) {
+        while (is_word_char(*src)) {
+            if (len == MAX_TOKEN) {
+                fail("name too long", 0);
+                break;
+            }
+            token[len++] = *src++;
+        }
+        // move() is the same as move
+        if (src[0] == '(' && src[1] == ')') src += 2;
+    } else if (*src != '\0') {
+        token[0] = *src;
+        token[1] = '\0';
+        fail("unexpected '%s'", token);
+        return;
+    }
+    token[len] = '\0';
+}
+
+static int is(const char *word) {
+    return strcmp(token, word) == 0;
+}
+
+static void emit8(int byte) {
+    if (pc >= KAREL_CODE_SIZE) {
+        fail("program too long", 0);
+        return;
+    }
+    code[pc++] = byte;
+}
+
+static void emit16(int value) {
+    emit8(value & 0xff);
+    emit8(value >> 8);
+}
+
+static void patch16(int at, int value) {
+    if (at + 1 < KAREL_CODE_SIZE) {
+        code[at] = value & 0xff;
+        code[at + 1] = value >> 8;
+    }
+}
+
+static struct func *find_func(const char *name) {
+    for (int i = 0; i < num_funcs; i++) {
+        if (strcmp(funcs[i].name, name) == 0) return &funcs[i];
+    }
+    return 0;
+}
+
+static int is_name(void) {
+    if (!is_word_char(token[0]) || (token[0] >= '0' && token[0] <= '9')) {
+        return 0;
+    }
+    for (int i = 0; i < COUNT(keywords); i++) {
+        if (is(keywords[i])) return 0;
+    }
+    for (int i = 0; i < COUNT(predicates); i++) {
+        if (is(predicates[i].name)) return 0;
+    }
+    return 1;
+}
+
+static int condition(void) {
+    int negate = 0;
+    if (is("not")) {
+        negate = COND_NOT;
+        advance();
+    }
+
+    for (int i = 0; i < COUNT(predicates); i++) {
+        if (is(predicates[i].name)) {
+            advance();
+            return predicates[i].cond ^ negate;
+        }
+    }
+    fail("unknown condition '%s'", token);
+    return 0;
+}
+
+static void statement(void);
+
+static void block(void) {
+    if (!is("{")) {
+        fail("expected '{' but got '%s'", token);
+        return;
+    }
+    if (++nesting > MAX_NESTING) {
+        fail("blocks nested too deeply", 0);
+        return;
+    }
+    advance();
+
+    while (!error && token[0] != '\0' && !is("}")) {
+        statement();
+    }
+    if (!is("}")) {
+        fail("missing '}'", 0);
+    }
+    advance();
+    nesting--;
+}
+
+static void define(void) {
+    advance();
+    if (!is_name()) {
+        fail("bad function name '%s'", token);
+        return;
+    }
+
+    // jump over the body when the program runs
+    emit8(OP_JUMP);
+    int skip = pc;
+    emit16(0);
+
+    struct func *f = find_func(token);
+    if (!f) {
+        if (num_funcs == MAX_FUNCS) {
+            fail("too many functions", 0);
+            return;
+        }
+        f = &funcs[num_funcs++];
+        memcpy(f->name, token, sizeof(f->name));
+    }
+    f->addr = pc;
+    defined_func = 1;
+
+    advance();
+    block();
+    emit8(OP_RETURN);
+    patch16(skip, pc);
+}
+
+static void call(void) {
+    if (!is_name()) {
+        fail("unexpected '%s'", token);
+        return;
+    }
+
+    emit8(OP_CALL);
+    struct func *f = find_func(token);
+    if (f) {
+        emit16(f->addr);
+    } else if (num_fixups < MAX_FIXUPS) {
+        // may be defined later in this program
+        memcpy(fixups[num_fixups].name, token, sizeof(token));
+        fixups[num_fixups++].at = pc;
+        emit16(0);
+    } else {
+        fail("too many calls", 0);
+    }
+    advance();
+}
+
+static void statement(void) {
+    if (is("move")) {
+        emit8(OP_MOVE);
+        advance();
+    } else if (is("turn_left")) {
+        emit8(OP_TURN_LEFT);
+        advance();
+    } else if (is("pick_beeper")) {
+        emit8(OP_PICK_BEEPER);
+        advance();
+    } else if (is("put_beeper")) {
+        emit8(OP_PUT_BEEPER);
+        advance();
+
+    } else if (is("repeat")) {
+        advance();
+        unsigned int count = 0;
+        const char *digit = token;
+        while (*digit >= '0' && *digit <= '9' && count <= 0xffff) {
+            count = count * 10 + (*digit++ - '0');
+        }
+        if (*digit != '\0' || token[0] == '\0' || count > 0xffff) {
+            fail("bad repeat count '%s'", token);
+            return;
+        }
+        advance();
+        emit8(OP_REPEAT);
+        emit16(count);
+        int exit = pc;
+        emit16(0);
+        int top = pc;
+        block();
+        emit8(OP_LOOP);
+        emit16(top);
+        patch16(exit, pc);
+
+    } else if (is("while")) {
+        // test once before the loop, then at the bottom
+        advance();
+        int cond = condition();
+        emit8(OP_JUMP_IF_NOT);
+        emit8(cond);
+        int exit = pc;
+        emit16(0);
+        int top = pc;
+        block();
+        emit8(OP_JUMP_IF);
+        emit8(cond);
+        emit16(top);
+        patch16(exit, pc);
+
+    } else if (is("if")) {
+        advance();
+        int cond = condition();
+        emit8(OP_JUMP_IF_NOT);
+        emit8(cond);
+        int skip_then = pc;
+        emit16(0);
+        block();
+
+        if (is("else")) {
+            advance();
+            emit8(OP_JUMP);
+            int skip_else = pc;
+            emit16(0);
+            patch16(skip_then, pc);
+            block();
+            patch16(skip_else, pc);
+        } else {
+            patch16(skip_then, pc);
+        }
+
+    } else if (is("def")) {
+        define();
+    } else {
+        call();
+    }
+}
+
+int karel_compile(const char *source) {
+    // saved so a failed compile changes nothing
+    struct func saved_funcs[MAX_FUNCS];
+    int saved_num_funcs = num_funcs;
+    memcpy(saved_funcs, funcs, sizeof(funcs));
+
+    src = source;
+    pc = kept_end;
+    error = 0;
+    nesting = 0;
+    num_fixups = 0;
+    defined_func = 0;
+    int entry = pc;
+
+    advance();
+    while (!error && token[0] != '\0') {
+        statement();
+    }
+    emit8(OP_HALT);
+
+    for (int i = 0; !error && i < num_fixups; i++) {
+        struct func *f = find_func(fixups[i].name);
+        if (f) {
+            patch16(fixups[i].at, f->addr);
+        } else {
+            memcpy(token, fixups[i].name, sizeof(token));
+            fail("unknown name '%s'", token);
+        }
+    }
+
+    if (error) {
+        num_funcs = saved_num_funcs;
+        memcpy(funcs, saved_funcs, sizeof(funcs));
+        return -1;
+    }
+
+    if (defined_func) {
+        kept_end = pc;
+    }
+    return entry;
+}
+
+const unsigned char *karel_bytecode(void) {
+    return code;
+}
+
+const char *karel_compile_error(void) {
+    return error ? error : "";
+}
+
+int karel_compile_size(void) {
+    return pc;
+}
@@ -0,0 +1,110 @@
+
+/*
+ * FILENAME: karel_sim.c
+ * -----------------------------------------
+ * Moves Karel around the board. Only game
+ * rules live here; input, drawing and timing
+ * are up to the caller.
+ */
+
+#include "karel_sim.h"
+#include "board.h"
+#include "tiles.h"
+#include "accel.h"
+
+static pos_t karel;
+static int bag;  // beepers Karel carries
+static int goal; // enum sim_goal
+
+void karel_sim_init(pos_t start) {
+    karel = start;
+}
+
+/*
+ * Applies move to pos. A move forward or backward
+ * must already be known not to be blocked.
+ */
+static inline void apply_move(pos_t *pos, int move) {
+
+    if (move == MOVE_FORWARD || move == MOVE_BACKWARD) {
+        int step = move == MOVE_FORWARD ? 1 : -1;
+
+        if (pos->dir == EAST) {
+            pos->x += step;
+        } else if (pos->dir == SOUTH) {
+            pos->y += step;
+        } else if (pos->dir == WEST) {
+            pos->x -= step;
+        } else if (pos->dir == NORTH) {
+            pos->y -= step;
+        }
+
+    } else if (move == TURN_LEFT) {
+        pos->dir = (pos->dir + 1) % 4;
+    } else if (move == TURN_RIGHT) {
+        pos->dir = (pos->dir + 3) % 4;
+    }
+}
+
+// whether a move cannot be made from pos
+static inline int is_blocked(pos_t pos, int move) {
+    if (move == MOVE_FORWARD) {
+        return !board_can_move(pos.x, pos.y, pos.dir);
+    } else if (move == MOVE_BACKWARD) {
+        return !board_can_move(pos.x, pos.y, (pos.dir + 2) % 4);
+    } else if (move == PICK_BEEPER) {
+        return !tiles_has_beeper(pos.x, pos.y);
+    } else if (move == PUT_BEEPER) {
+        return bag == 0;
+    }
+    return 0;
+}
+
+int karel_sim_step(int move) {
+
+    if (is_blocked(karel, move)) {
+        return SIM_BLOCKED;
+    }
+
+    if (move == PICK_BEEPER) {
+        tiles_remove_beeper(karel.x, karel.y);
+        bag++;
+    } else if (move == PUT_BEEPER) {
+        if (!tiles_add_beeper(karel.x, karel.y)) {
+            return SIM_BLOCKED; // no room for another beeper
+        }
+        bag--;
+    } else {
+        apply_move(&karel, move);
+    }
+
+    // check if game is over (beepers are counted by the tile index)
+    if (goal == GOAL_COLLECT_ALL ? tiles_total_beepers() == 0
+                                 : tiles_has_beeper(karel.x, karel.y)) {
+        return SIM_FINISHED;
+    }
+    return SIM_OK;
+}
+
+void karel_sim_set_goal(int new_goal) {
+    goal = new_goal;
+}
+
+void karel_sim_set_bag(int beepers) {
+    bag = beepers;
+}
+
+int karel_sim_bag(void) {
+    return bag;
+}
+
+pos_t karel_sim_peek(pos_t pos, int move) {
+    if (!is_blocked(pos, move)) {
+        apply_move(&pos, move);
+    }
+    return pos;
+}
+
+pos_t karel_sim_position(void) {
+    return karel;
+}
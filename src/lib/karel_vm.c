@@ -0,0 +1,171 @@
+
+/*
+ * FILENAME: karel_vm.c
+ * ------------------------------------------------
+ * Runs bytecode from karel_compile. Instructions
+ * are dispatched by jumping straight from the end
+ * of one handler to the next through a table of
+ * label addresses (GCC's computed goto), so there
+ * is no central switch to branch back through.
+ */
+
+#include "karel_vm.h"
+#include "board.h"
+#include "tiles.h"
+#include "accel.h"
+
+#define MAX_CALLS 64 // deepest function call nesting
+#define MAX_LOOPS 64 // most repeat loops running at once
+
+#define READ16(p) ((p)[0] | (p)[1] << 8)
+
+static int check_condition(int cond) {
+    pos_t karel = karel_sim_position();
+    int holds;
+
+    switch (cond & ~COND_NOT) {
+        case COND_FRONT_CLEAR:
+            holds = board_can_move(karel.x, karel.y, karel.dir);
+            break;
+        case COND_BEEPERS_PRESENT:
+            holds = tiles_has_beeper(karel.x, karel.y);
+            break;
+        case COND_FACING_EAST:
+            holds = karel.dir == EAST;
+            break;
+        case COND_FACING_NORTH:
+            holds = karel.dir == NORTH;
+            break;
+        case COND_FACING_WEST:
+            holds = karel.dir == WEST;
+            break;
+        default:
+            holds = karel.dir == SOUTH;
+            break;
+    }
+    return (cond & COND_NOT) ? !holds : holds;
+}
+
+karel_vm_result_t karel_vm_run(const unsigned char *code, int entry,
+                               unsigned int max_instructions,
+                               void (*render)(pos_t karel),
+                               unsigned int render_every) {
+    static const void *const dispatch[NUM_OPS] = {
+        [OP_HALT] = &&op_halt,
+        [OP_MOVE] = &&op_move,
+        [OP_TURN_LEFT] = &&op_turn_left,
+        [OP_PICK_BEEPER] = &&op_pick_beeper,
+        [OP_PUT_BEEPER] = &&op_put_beeper,
+        [OP_JUMP] = &&op_jump,
+        [OP_JUMP_IF_NOT] = &&op_jump_if_not,
+        [OP_JUMP_IF] = &&op_jump_if,
+        [OP_REPEAT] = &&op_repeat,
+        [OP_LOOP] = &&op_loop,
+        [OP_CALL] = &&op_call,
+        [OP_RETURN] = &&op_return,
+    };
+
+    unsigned short calls[MAX_CALLS];  // return addresses
+    unsigned short counts[MAX_LOOPS]; // iterations left in each repeat
+    int num_calls = 0, num_loops = 0;
+
+    karel_vm_result_t result = {VM_HALTED, 0, 0};
+    const unsigned char *ip = code + entry;
+    int move, sim;
+
+    // counting every instruction also stops empty endless loops
+#define DISPATCH()                                      \
+    do {                                                \
+        if (result.instructions++ == max_instructions)  \
+            goto out_of_instructions;                   \
+        goto *dispatch[*ip];                            \
+    } while (0)
+
+    DISPATCH();
+
+op_move:
+    move = MOVE_FORWARD;
+    goto act;
+op_turn_left:
+    move = TURN_LEFT;
+    goto act;
+op_pick_beeper:
+    move = PICK_BEEPER;
+    goto act;
+op_put_beeper:
+    move = PUT_BEEPER;
+act:
+    ip++;
+    sim = karel_sim_step(move);
+    result.actions++;
+    if (render && render_every && result.actions % render_every == 0) {
+        render(karel_sim_position());
+    }
+    if (sim == SIM_BLOCKED) {
+        result.status = VM_BLOCKED;
+        goto done;
+    } else if (sim == SIM_FINISHED) {
+        result.status = VM_FINISHED;
+        goto done;
+    }
+    DISPATCH();
+
+op_jump:
+    ip = code + READ16(ip + 1);
+    DISPATCH();
+
+op_jump_if_not:
+    ip = check_condition(ip[1]) ? ip + 4 : code + READ16(ip + 2);
+    DISPATCH();
+
+op_jump_if:
+    ip = check_condition(ip[1]) ? code + READ16(ip + 2) : ip + 4;
+    DISPATCH();
+
+op_repeat:
+    if (READ16(ip + 1) == 0) {
+        ip = code + READ16(ip + 3);
+        DISPATCH();
+    }
+    if (num_loops == MAX_LOOPS) goto stack_overflow;
+    counts[num_loops++] = READ16(ip + 1);
+    ip += 5;
+    DISPATCH();
+
+op_loop:
+    if (--counts[num_loops - 1] > 0) {
+        ip = code + READ16(ip + 1);
+    } else {
+        num_loops--;
+        ip += 3;
+    }
+    DISPATCH();
+
+op_call:
+    if (num_calls == MAX_CALLS) goto stack_overflow;
+    calls[num_calls++] = ip + 3 - code;
+    ip = code + READ16(ip + 1);
+    DISPATCH();
+
+op_return:
+    if (num_calls == 0) goto done;
+    ip = code + calls[--num_calls];
+    DISPATCH();
+
+stack_overflow:
+    result.status = VM_STACK;
+    goto done;
+
+out_of_instructions:
+    result.instructions--;
+    result.status = VM_LIMIT;
+    goto done;
+
+op_halt:
+done:
+    if (render) {
+        render(karel_sim_position());
+    }
+    return result;
+#undef DISPATCH
+}
@@ -8,9 +8,16 @@
 
 #include "karel_world.h"
 #include "board.h"
+#include "distfield.h"
+#include "script.h"
+#include "replay.h"
+#include "journal.h"
+#include "tiles.h"
 #include "accel.h"
-#include "strings.h"
+#include "keys.h"
+#include "input.h"
 #include "timer.h"
+#include "sched.h"
 #include "printf.h"
 
 const unsigned int DELAY_MS = 250;
@@ -37,94 +44,226 @@ const char *board[NUM_ROWS] =
 
 };
 
-// set karel's starting position and direction
-static pos_t karel;
-static pos_t beeper = (pos_t) {-10, -10, -10}; // no beeper by default
-
 const unsigned int DISPLAY_DIM = 3;
 
+// where Karel starts the level
+#define START_X 0
+#define START_Y (NUM_ROWS - 1)
+
+/*
+ * Puts the level's beepers back, empties Karel's bag
+ * and moves him to the start
+ */
+static void reset_level(void) {
+    board_load(board, NUM_ROWS, DISPLAY_DIM);
+    distfield_compute();
+    karel_sim_set_bag(0);
+    karel_sim_init((pos_t) {START_X, START_Y, EAST});
+}
+
 void karel_world_init() {
-    accel_init();
+    input_init();
+    if (!input_add(&input_sensor)) {
+        printf("Playing with the keyboard only\n");
+    }
+    input_add(&input_keys);
     board_init(board, NUM_ROWS, DISPLAY_DIM);
+    reset_level();
+    replay_record_start(karel_sim_position(), timer_get_ticks());
+    journal_init(karel_sim_position());
+
+    printf("Start!\n");
+    pos_t karel = karel_sim_position();
+    draw_board(karel.x, karel.y, karel.dir);
+}
+
+// most commands a script may run before we give up on it
+#define SCRIPT_MAX_CMDS 10000000
+
+// number of steps of the shortest path shown as a hint
+#define HINT_LEN 8
+
+void karel_world_show_hint() {
+    int xs[HINT_LEN], ys[HINT_LEN];
+    int count = 0;
+    pos_t karel = karel_sim_position();
+    pos_t cur = karel;
+
+    // follow the distance field and collect the cells Karel walks through
+    while (count < HINT_LEN) {
+        int move = distfield_next_move(cur);
+        if (move < 0) break;
 
-    // set karel's starting position and direction
-    karel = (pos_t) {0, NUM_ROWS - 1, EAST};
-
-    // check if we have beeper
-    int width = strlen(board[0]);
-    for (int y = 0; y < NUM_ROWS; y++) {
-        for (int x = 0; x < width; x++) {
-            if (board[y][x] == BEEPER) {
-                beeper.x = x;
-                beeper.y = y;
-            }
+        if (move == TURN_LEFT) {
+            cur.dir = (cur.dir + 1) % 4;
+        } else {
+            cur.x += (cur.dir == EAST) - (cur.dir == WEST);
+            cur.y += (cur.dir == SOUTH) - (cur.dir == NORTH);
+            xs[count] = cur.x;
+            ys[count] = cur.y;
+            count++;
         }
     }
 
-    printf("Start!\n");
+    board_set_hint(xs, ys, count);
     draw_board(karel.x, karel.y, karel.dir);
 }
 
+int karel_world_moves_remaining() {
+    return distfield_get(karel_sim_position());
+}
+
+static void render_karel(pos_t karel) {
+    draw_board(karel.x, karel.y, karel.dir);
+}
+
+int karel_world_run_script(script_cmd_t *prog, int len,
+                           unsigned int render_every) {
+    if (script_compile(prog, len) < 0) {
+        printf("script: unbalanced loops\n");
+        return SCRIPT_DONE;
+    }
+
+    board_set_hint(0, 0, 0);
+    unsigned long long start = timer_get_ticks64();
+    script_result_t result = script_run(prog, len, SCRIPT_MAX_CMDS,
+                                        render_karel, render_every);
+    unsigned int elapsed = timer_get_ticks64() - start;
+
+    printf("script: %d steps in %d us, status %d\n",
+           result.steps, elapsed, result.status);
+    return result.status;
+}
+
+void karel_world_replay(int realtime) {
+    board_set_hint(0, 0, 0);
+    reset_level();
+    unsigned long long start = timer_get_ticks64();
+    replay_result_t result = replay_run(realtime ? sched_sleep_ms : 0, render_karel);
+    unsigned int elapsed = timer_get_ticks64() - start;
+
+    printf("replay: %d moves in %d us, status %d\n",
+           result.moves, elapsed, result.status);
+}
+
 /*
- * Checks if Karel is within the bounds of the maze
- * Returns 1 if it is, 0 if not.
- *
- * @precon  must be called when the move is forward
+ * Keeps the distance field in step after a move
+ * that may have picked or put a beeper
  */
-int is_move_valid(int x, int y) {
-           // within cols
-    return x >= 0 && x < strlen(board[0]) 
+static void update_beepers(int move) {
+    if (move == PICK_BEEPER || move == PUT_BEEPER) {
+        pos_t karel = karel_sim_position();
+        distfield_update(karel.x, karel.y);
+    }
+}
 
-            // within rows
-            && y >= 0 && y < NUM_ROWS 
+// set when the whole board needs to be drawn again
+static int dirty = 1;
 
-            // doesn't collide with west wall
-            && !(board[y][x] == WEST_WALL && karel.dir == EAST)
-            && !(board[karel.y][karel.x] == WEST_WALL && karel.dir == WEST)
+// time a move is animated over, less than the pause between moves
+#define MOVE_ANIM_US 200000
 
-            // doesn't collide with east wall
-            && !(board[y][x] == SOUTH_WALL && karel.dir == NORTH)
-            && !(board[karel.y][karel.x] == SOUTH_WALL 
-                    && karel.dir == SOUTH);
+// the move being animated
+static struct {
+    pos_t from;
+    pos_t to;
+    unsigned int start_us;
+    int running;
+} anim;
 
+/*
+ * Shows a move Karel just made from the given
+ * position. Picks and puts change the tiles, so the
+ * board is drawn again; other moves are animated.
+ */
+static void show_move(pos_t from, int move) {
+    if (move == PICK_BEEPER || move == PUT_BEEPER) {
+        dirty = 1;
+        return;
+    }
+    anim.from = from;
+    anim.to = karel_sim_position();
+    anim.start_us = timer_get_ticks();
+    anim.running = 1;
 }
 
-int update_karel_world() {
-    int move = accel_read_move();
-    pos_t next_move = karel;
-
-    // check moves
-    if (move == MOVE_FORWARD) {
-
-        if (karel.dir == EAST) {
-            next_move.x++; // no bounds or wall checking!
-        } else if (karel.dir == SOUTH) {
-            next_move.y++;
-        } else if (karel.dir == WEST) {
-            next_move.x--;
-        } else if (karel.dir == NORTH) {
-            next_move.y--;
-        }
+/*
+ * Takes back Karel's last move, recording the move
+ * that undoes it so replays stay in step.
+ */
+static int undo_move(void) {
+    pos_t from = karel_sim_position();
+    int inverse = journal_undo();
+    if (inverse < 0) {
+        printf("\a"); // nothing to undo
+        return SIM_BLOCKED;
+    }
 
-        if (!is_move_valid(next_move.x, next_move.y)) {
-            printf("\a"); // shell bell!
-            timer_delay_ms(DELAY_MS);
-            return 0;
-        }
+    replay_record(inverse, timer_get_ticks());
+    update_beepers(inverse);
+    board_set_hint(0, 0, 0);
+    show_move(from, inverse);
+    return SIM_OK;
+}
+
+int karel_world_apply(int move) {
+    if (move == MOVE_BACKWARD) {
+        return undo_move();
+    }
 
-        karel = next_move; // update karel
+    pos_t from = karel_sim_position();
+    replay_record(move, timer_get_ticks());
+    int result = karel_sim_step(move);
 
-    } else if (move == TURN_LEFT) {
-        karel.dir = (karel.dir + 1) % 4;
+    if (result == SIM_BLOCKED) {
+        printf("\a"); // shell bell!
+        return result;
     }
-    
-    draw_board(karel.x, karel.y, karel.dir);
-    timer_delay_ms(DELAY_MS);
+    journal_push(move);
+    update_beepers(move);
 
-    // check if game is over
-    if (karel.x == beeper.x && karel.y == beeper.y) {
+    if (move != TURN_LEFT) {
+        board_set_hint(0, 0, 0); // old hint no longer applies
+    }
+    show_move(from, move);
+    return result;
+}
+
+int karel_world_draw(void) {
+    if (dirty) {
+        pos_t karel = karel_sim_position();
+        draw_board(karel.x, karel.y, karel.dir);
+        dirty = anim.running = 0;
         return 1;
     }
+    if (!anim.running) return 0;
+
+    unsigned int elapsed = timer_get_ticks() - anim.start_us;
+    int progress = KAREL_MOVE_STEPS;
+    if (elapsed < MOVE_ANIM_US) {
+        progress = elapsed * KAREL_MOVE_STEPS / MOVE_ANIM_US;
+    } else {
+        anim.running = 0; // last frame of the move
+    }
 
-    return 0;
+    draw_karel_move(anim.from.x, anim.from.y, anim.from.dir,
+                    anim.to.x, anim.to.y, anim.to.dir, progress);
+    return 1;
+}
+
+int update_karel_world() {
+    int result = karel_world_apply(input_read());
+
+    // animate the move a frame at a time, sleeping in between, until
+    // the next one may be read
+    unsigned int end = timer_get_ticks() + DELAY_MS * 1000;
+    unsigned int next_frame = timer_get_ticks();
+    while ((int) (end - timer_get_ticks()) > 0) {
+        karel_world_draw();
+        next_frame += KAREL_FRAME_US;
+        sched_sleep_until((int) (next_frame - end) < 0 ? next_frame : end);
+    }
+
+    // check if game is over
+    return result == SIM_FINISHED;
 }
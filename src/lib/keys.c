@@ -0,0 +1,74 @@
+
+/*
+ * FILENAME: keys.c
+ * ------------------------------------------------
+ * Scancodes arrive from the PS/2 interrupt handler
+ * and are decoded here, as in keyboard.c: a release
+ * comes as F0 before the key's code, and the arrows
+ * are the keypad's 8, 2, 4 and 6 with an E0 before
+ * them. The E0 is skipped, so the keypad's arrows
+ * work too.
+ */
+
+#include "keys.h"
+#include "accel.h"
+#include "ps2.h"
+#include "ps2_keys.h"
+#include "gpio.h"
+
+#define KEYS_CLOCK GPIO_PIN20
+#define KEYS_DATA  GPIO_PIN21
+
+// set 2 scancodes of the keys that make moves
+#define CODE_UP    0x75
+#define CODE_DOWN  0x72
+#define CODE_LEFT  0x6B
+#define CODE_RIGHT 0x74
+
+static ps2_device_t *dev;
+static int released; // the next code is a key let go
+
+// the move a key makes, or -1 if none
+static int key_move(unsigned char code) {
+    switch (code) {
+        case CODE_UP:    return MOVE_FORWARD;
+        case CODE_DOWN:  return MOVE_BACKWARD;
+        case CODE_LEFT:  return TURN_LEFT;
+        case CODE_RIGHT: return TURN_RIGHT;
+        default:         return -1;
+    }
+}
+
+int keys_init(void) {
+    if (!dev) {
+        dev = ps2_new(KEYS_CLOCK, KEYS_DATA);
+    }
+    released = 0;
+    return 1;
+}
+
+int keys_poll_move(void) {
+    while (ps2_has_scancode(dev)) {
+        unsigned char code = ps2_read(dev);
+        if (code == PS2_CODE_EXTENDED) {
+            continue;
+        } else if (code == PS2_CODE_RELEASE) {
+            released = 1;
+            continue;
+        }
+
+        int move = released ? -1 : key_move(code);
+        released = 0;
+        if (move >= 0) {
+            return move;
+        }
+    }
+    return -1;
+}
+
+// drops the keys typed so far
+static void keys_flush(void) {
+    while (keys_poll_move() >= 0) {}
+}
+
+const input_source_t input_keys = {"keys", keys_init, keys_poll_move, keys_flush};
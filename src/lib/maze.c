@@ -0,0 +1,222 @@
+
+/*
+ * FILENAME: maze.c
+ * ------------------------------------------------
+ * Maze generators. Each algorithm carves a spanning
+ * tree of passages, recording for every cell whether
+ * its south and west sides are open. The result is
+ * then written into the board.
+ *
+ * rand() always starts from the same fixed seed, so
+ * we run our own xorshift generator from the seed we
+ * are given, and only use rand() to pick a seed.
+ */
+
+#include "maze.h"
+#include "board.h"
+#include "rand.h"
+
+#define MAX_CELLS (BOARD_MAX_ROWS * BOARD_MAX_COLS)
+
+// bits in passages[]
+#define OPEN_SOUTH 0x1
+#define OPEN_WEST  0x2
+#define VISITED    0x4
+
+static unsigned char passages[MAX_CELLS];
+
+// scratch space shared by the algorithms
+static unsigned short stack[MAX_CELLS];      // backtracker
+static unsigned short parent[MAX_CELLS];     // kruskal
+static unsigned short edges[2 * MAX_CELLS];  // kruskal
+static unsigned char walk_dir[MAX_CELLS];    // wilson
+
+static int num_rows, num_cols;
+static unsigned int rng_state;
+
+static unsigned int next_random(void) {
+    unsigned int x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng_state = x;
+    return x;
+}
+
+// random number in [0, n)
+static inline unsigned int random_below(unsigned int n) {
+    return next_random() % n;
+}
+
+/*
+ * Returns the neighbour of cell in direction dir,
+ * or -1 if it would be off the board
+ */
+static int neighbour(int cell, int dir) {
+    int x = cell % num_cols, y = cell / num_cols;
+
+    if (dir == EAST) x++;
+    else if (dir == WEST) x--;
+    else if (dir == SOUTH) y++;
+    else y--;
+
+    if (x < 0 || x >= num_cols || y < 0 || y >= num_rows) return -1;
+    return y * num_cols + x;
+}
+
+/*
+ * Opens the side of cell facing dir. Each wall is
+ * owned by the cell south or east of it.
+ */
+static void carve(int cell, int dir) {
+    if (dir == SOUTH) passages[cell] |= OPEN_SOUTH;
+    else if (dir == WEST) passages[cell] |= OPEN_WEST;
+    else if (dir == NORTH) passages[cell - num_cols] |= OPEN_SOUTH;
+    else passages[cell + 1] |= OPEN_WEST;
+}
+
+static void backtracker(int num_cells) {
+    int top = 0;
+    int start = random_below(num_cells);
+    passages[start] |= VISITED;
+    stack[top++] = start;
+
+    while (top > 0) {
+        int cell = stack[top - 1];
+
+        // collect unvisited neighbours
+        int choices[4], num_choices = 0;
+        for (int dir = 0; dir < 4; dir++) {
+            int next = neighbour(cell, dir);
+            if (next >= 0 && !(passages[next] & VISITED)) {
+                choices[num_choices++] = dir;
+            }
+        }
+
+        if (num_choices == 0) {
+            top--; // dead end, back up
+            continue;
+        }
+
+        int dir = choices[random_below(num_choices)];
+        int next = neighbour(cell, dir);
+        carve(cell, dir);
+        passages[next] |= VISITED;
+        stack[top++] = next;
+    }
+}
+
+// union-find root, halving the path as we go
+static int find(int cell) {
+    while (parent[cell] != cell) {
+        parent[cell] = parent[parent[cell]];
+        cell = parent[cell];
+    }
+    return cell;
+}
+
+static void kruskal(int num_cells) {
+    int num_edges = 0;
+
+    // every cell owns the edge to its south and west
+    for (int cell = 0; cell < num_cells; cell++) {
+        parent[cell] = cell;
+        if (cell / num_cols < num_rows - 1) edges[num_edges++] = cell * 2;
+        if (cell % num_cols > 0) edges[num_edges++] = cell * 2 + 1;
+    }
+
+    // shuffle edges (Fisher-Yates)
+    for (int i = num_edges - 1; i > 0; i--) {
+        int j = random_below(i + 1);
+        unsigned short tmp = edges[i];
+        edges[i] = edges[j];
+        edges[j] = tmp;
+    }
+
+    for (int i = 0; i < num_edges; i++) {
+        int cell = edges[i] / 2;
+        int dir = (edges[i] & 1) ? WEST : SOUTH;
+        int a = find(cell);
+        int b = find(neighbour(cell, dir));
+
+        if (a != b) {
+            parent[a] = b;
+            carve(cell, dir);
+        }
+    }
+}
+
+static void wilson(int num_cells) {
+    passages[random_below(num_cells)] |= VISITED;
+
+    for (int start = 0; start < num_cells; start++) {
+        if (passages[start] & VISITED) continue;
+
+        // random walk until we hit the maze; overwriting
+        // walk_dir erases any loops in the walk
+        int cell = start;
+        while (!(passages[cell] & VISITED)) {
+            int dir, next;
+            do {
+                dir = random_below(4);
+                next = neighbour(cell, dir);
+            } while (next < 0);
+            walk_dir[cell] = dir;
+            cell = next;
+        }
+
+        // add the loop-erased walk to the maze
+        cell = start;
+        while (!(passages[cell] & VISITED)) {
+            passages[cell] |= VISITED;
+            carve(cell, walk_dir[cell]);
+            cell = neighbour(cell, walk_dir[cell]);
+        }
+    }
+}
+
+/*
+ * Writes the carved maze into the board
+ */
+static void write_board(int num_cells) {
+    for (int cell = 0; cell < num_cells; cell++) {
+        int x = cell % num_cols, y = cell / num_cols;
+
+        // walls on the edge of the board are implicit
+        if (y < num_rows - 1 && !(passages[cell] & OPEN_SOUTH)) {
+            board_set_wall(x, y, SOUTH, 1);
+        }
+        if (x > 0 && !(passages[cell] & OPEN_WEST)) {
+            board_set_wall(x, y, WEST, 1);
+        }
+    }
+}
+
+unsigned int maze_generate(int nrows, int ncols, unsigned int seed,
+                           enum maze_algorithm algorithm) {
+    while (seed == 0) {
+        seed = rand();
+    }
+    rng_state = seed;
+
+    num_rows = nrows;
+    num_cols = ncols;
+    int num_cells = nrows * ncols;
+    for (int cell = 0; cell < num_cells; cell++) {
+        passages[cell] = 0;
+    }
+
+    if (algorithm == MAZE_KRUSKAL) {
+        kruskal(num_cells);
+    } else if (algorithm == MAZE_WILSON) {
+        wilson(num_cells);
+    } else {
+        backtracker(num_cells);
+    }
+
+    board_new(nrows, ncols);
+    write_board(num_cells);
+
+    board_set_tile(ncols - 1, 0, BEEPER);
+    return seed;
+}
@@ -0,0 +1,49 @@
+
+/*
+ * FILENAME: move_queue.c
+ * ------------------------------------------------
+ * The writer only changes tail and the reader only
+ * head, and each stores the move or takes it before
+ * moving its index on. Both indexes count up without
+ * wrapping to the queue's size, so the queue is full
+ * when they are MOVE_QUEUE_SIZE apart. Everything
+ * shared is volatile, so the compiler keeps these
+ * stores in order.
+ */
+
+#include "move_queue.h"
+
+static volatile unsigned char moves[MOVE_QUEUE_SIZE];
+static volatile unsigned int head; // next move popped
+static volatile unsigned int tail; // next move pushed
+static volatile int dropped;
+
+int move_queue_push(int move) {
+    if (tail - head == MOVE_QUEUE_SIZE) {
+        dropped++;
+        return 0;
+    }
+    moves[tail % MOVE_QUEUE_SIZE] = move;
+    tail++;
+    return 1;
+}
+
+int move_queue_pop(void) {
+    if (head == tail) return -1;
+
+    int move = moves[head % MOVE_QUEUE_SIZE];
+    head++;
+    return move;
+}
+
+int move_queue_count(void) {
+    return tail - head;
+}
+
+int move_queue_dropped(void) {
+    return dropped;
+}
+
+void move_queue_clear(void) {
+    head = tail;
+}
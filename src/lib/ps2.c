@@ -132,3 +132,8 @@ unsigned char ps2_read(ps2_device_t *dev)
     rb_dequeue(dev->queue, (int *) &queued_data);      
     return queued_data;
 }
+
+bool ps2_has_scancode(ps2_device_t *dev)
+{
+    return !rb_empty(dev->queue);
+}
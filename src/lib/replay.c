@@ -0,0 +1,153 @@
+
+/*
+ * FILENAME: replay.c
+ * ------------------------------------------------
+ * Records moves into a ring of bytes. The first
+ * byte of a move holds the move and the low bits of
+ * its delay; the rest of the delay follows 7 bits
+ * per byte. The top bit of a byte is set when more
+ * bytes of the same move follow.
+ */
+
+#include "replay.h"
+#include "printf.h"
+
+#define MORE       0x80
+#define MOVE_SHIFT 4
+#define MOVE_MASK  0x7
+#define FIRST_BITS 4     // delay bits in the first byte
+#define MAX_BYTES  6     // longest encoded move
+
+static unsigned char ring[REPLAY_BUFFER_SIZE];
+static int head; // oldest byte
+static int used; // bytes in the ring
+static int num_moves;
+
+static pos_t start_pos;     // where the oldest move starts
+static unsigned int last_us; // time of the previous move
+
+static int encode(int move, unsigned int delay_ms, unsigned char *out) {
+    int len = 0;
+    out[len++] = (move & MOVE_MASK) << MOVE_SHIFT | (delay_ms & 0xf);
+    delay_ms >>= FIRST_BITS;
+
+    while (delay_ms > 0) {
+        out[len - 1] |= MORE;
+        out[len++] = delay_ms & 0x7f;
+        delay_ms >>= 7;
+    }
+    return len;
+}
+
+/*
+ * Decodes the move starting at ring offset *pos and
+ * moves *pos past it. Returns the move.
+ */
+static int decode(int *pos, unsigned int *delay_ms) {
+    unsigned char byte = ring[*pos];
+    int move = (byte >> MOVE_SHIFT) & MOVE_MASK;
+    unsigned int delay = byte & 0xf;
+    int shift = FIRST_BITS;
+
+    *pos = (*pos + 1) % REPLAY_BUFFER_SIZE;
+    while (byte & MORE) {
+        byte = ring[*pos];
+        if (shift < 32) {
+            delay |= (unsigned int) (byte & 0x7f) << shift;
+        }
+        shift += 7;
+        *pos = (*pos + 1) % REPLAY_BUFFER_SIZE;
+    }
+    *delay_ms = delay;
+    return move;
+}
+
+// drops the oldest move, moving the start past it
+static void drop_oldest(void) {
+    unsigned int delay_ms;
+    int pos = head;
+    int move = decode(&pos, &delay_ms);
+
+    used -= (pos - head + REPLAY_BUFFER_SIZE) % REPLAY_BUFFER_SIZE;
+    head = pos;
+    num_moves--;
+    start_pos = karel_sim_peek(start_pos, move);
+}
+
+void replay_record_start(pos_t start, unsigned int now_us) {
+    head = used = num_moves = 0;
+    start_pos = start;
+    last_us = now_us;
+}
+
+void replay_record(int move, unsigned int now_us) {
+    unsigned int delay_ms = (now_us - last_us) / 1000;
+    last_us += delay_ms * 1000; // keep the remainder for next time
+
+    unsigned char bytes[MAX_BYTES];
+    int len = encode(move, delay_ms, bytes);
+
+    while (used + len > REPLAY_BUFFER_SIZE) {
+        drop_oldest();
+    }
+    for (int i = 0; i < len; i++) {
+        ring[(head + used++) % REPLAY_BUFFER_SIZE] = bytes[i];
+    }
+    num_moves++;
+}
+
+int replay_num_moves(void) {
+    return num_moves;
+}
+
+int replay_size(void) {
+    return used;
+}
+
+void replay_dump(void) {
+    printf("replay: %d moves, %d bytes, start %d %d %d\n",
+           num_moves, used, start_pos.x, start_pos.y, start_pos.dir);
+
+    for (int i = 0; i < used; i++) {
+        printf("%02x%c", ring[(head + i) % REPLAY_BUFFER_SIZE],
+               (i % 16 == 15 || i == used - 1) ? '\n' : ' ');
+    }
+}
+
+int replay_load(pos_t start, const unsigned char *data, int len) {
+    if (len > REPLAY_BUFFER_SIZE || (len > 0 && (data[len - 1] & MORE))) {
+        return -1;
+    }
+
+    head = 0;
+    used = len;
+    num_moves = 0;
+    start_pos = start;
+    for (int i = 0; i < len; i++) {
+        ring[i] = data[i];
+        num_moves += !(data[i] & MORE);
+    }
+    return num_moves;
+}
+
+replay_result_t replay_run(void (*wait_ms)(unsigned int ms),
+                           void (*render)(pos_t karel)) {
+    replay_result_t result = {SIM_OK, 0};
+    int pos = head;
+
+    karel_sim_init(start_pos);
+    for (int i = 0; i < num_moves; i++) {
+        unsigned int delay_ms;
+        int move = decode(&pos, &delay_ms);
+
+        if (wait_ms) {
+            wait_ms(delay_ms);
+        }
+        result.status = karel_sim_step(move);
+        result.moves++;
+        if (render) {
+            render(karel_sim_position());
+        }
+    }
+    return result;
+}
@@ -0,0 +1,125 @@
+
+/*
+ * FILENAME: sched.c
+ * ------------------------------------------------
+ * Keeps the waiting callbacks in a small table and
+ * scans it for the earliest one; with at most
+ * SCHED_MAX_EVENTS of them a heap would not pay off.
+ * Times are compared by their signed difference, so
+ * they keep working when the clock wraps around.
+ */
+
+#include "sched.h"
+
+static struct event {
+    unsigned int when_us;
+    unsigned int period_us;
+    sched_fn_t fn; // 0 for a free slot
+    void *aux;
+} events[SCHED_MAX_EVENTS];
+
+// the simulated clock
+static unsigned int sim_us;
+
+static unsigned int sim_now(void) {
+    return sim_us;
+}
+
+static void sim_idle(unsigned int until_us) {
+    if ((int) (until_us - sim_us) > 0) {
+        sim_us = until_us;
+    }
+}
+
+static unsigned int (*clock_now)(void) = sim_now;
+static void (*clock_idle)(unsigned int until_us) = sim_idle;
+
+static inline int before(unsigned int a, unsigned int b) {
+    return (int) (a - b) < 0;
+}
+
+// index of the earliest callback, or -1 if there are none
+static int earliest(void) {
+    int first = -1;
+    for (int i = 0; i < SCHED_MAX_EVENTS; i++) {
+        if (events[i].fn && (first < 0 || before(events[i].when_us, events[first].when_us))) {
+            first = i;
+        }
+    }
+    return first;
+}
+
+void sched_init(unsigned int (*now_us)(void), void (*idle)(unsigned int until_us)) {
+    for (int i = 0; i < SCHED_MAX_EVENTS; i++) {
+        events[i].fn = 0;
+    }
+    clock_now = now_us ? now_us : sim_now;
+    clock_idle = idle ? idle : sim_idle;
+}
+
+int sched_add(unsigned int when_us, unsigned int period_us, sched_fn_t fn, void *aux) {
+    for (int i = 0; i < SCHED_MAX_EVENTS; i++) {
+        if (!events[i].fn) {
+            events[i] = (struct event) {when_us, period_us, fn, aux};
+            return i;
+        }
+    }
+    return -1;
+}
+
+void sched_cancel(int id) {
+    if (id >= 0 && id < SCHED_MAX_EVENTS) {
+        events[id].fn = 0;
+    }
+}
+
+int sched_run(void) {
+    unsigned int now = clock_now();
+    int ran = 0;
+    int i;
+
+    while ((i = earliest()) >= 0 && !before(now, events[i].when_us)) {
+        struct event event = events[i];
+
+        if (event.period_us) {
+            events[i].when_us += event.period_us;
+            if (!before(now, events[i].when_us)) {
+                events[i].when_us = now + event.period_us; // skip missed periods
+            }
+        } else {
+            events[i].fn = 0; // free before the call, so it may add itself again
+        }
+        event.fn(event.aux);
+        ran++;
+    }
+    return ran;
+}
+
+void sched_sleep_until(unsigned int when_us) {
+    while (1) {
+        sched_run();
+        if (!before(clock_now(), when_us)) {
+            return;
+        }
+
+        // wake for the next callback if it comes first
+        unsigned int until = when_us;
+        int next = earliest();
+        if (next >= 0 && before(events[next].when_us, until)) {
+            until = events[next].when_us;
+        }
+        clock_idle(until);
+    }
+}
+
+void sched_sleep_ms(unsigned int ms) {
+    sched_sleep_until(clock_now() + ms * 1000);
+}
+
+unsigned int sched_now(void) {
+    return clock_now();
+}
+
+void sched_sim_set(unsigned int now_us) {
+    sim_us = now_us;
+}
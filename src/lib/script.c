@@ -0,0 +1,118 @@
+
+/*
+ * FILENAME: script.c
+ * ------------------------------------------------
+ * Runs compiled Karel programs. An opening REPEAT
+ * or WHILE jumps past its END when the loop is
+ * over, and an END jumps back to its opener.
+ */
+
+#include "script.h"
+#include "board.h"
+#include "tiles.h"
+#include "accel.h"
+
+// deepest nesting of loops
+#define MAX_DEPTH 16
+
+int script_compile(script_cmd_t *prog, int len) {
+    unsigned short openers[MAX_DEPTH];
+    int depth = 0;
+
+    for (int i = 0; i < len; i++) {
+        if (prog[i].op == SCRIPT_REPEAT || prog[i].op == SCRIPT_WHILE) {
+            if (depth == MAX_DEPTH) return -1;
+            openers[depth++] = i;
+
+        } else if (prog[i].op == SCRIPT_END) {
+            if (depth == 0) return -1;
+            int opener = openers[--depth];
+            prog[opener].jump = i + 1; // leave the loop
+            prog[i].jump = opener;     // next iteration
+        }
+    }
+    return depth == 0 ? 0 : -1;
+}
+
+static int check_condition(int cond) {
+    pos_t karel = karel_sim_position();
+
+    if (cond == COND_FRONT_IS_CLEAR) {
+        return board_can_move(karel.x, karel.y, karel.dir);
+    } else if (cond == COND_FRONT_IS_BLOCKED) {
+        return !board_can_move(karel.x, karel.y, karel.dir);
+    } else if (cond == COND_ON_BEEPER) {
+        return tiles_has_beeper(karel.x, karel.y);
+    } else {
+        return !tiles_has_beeper(karel.x, karel.y);
+    }
+}
+
+script_result_t script_run(const script_cmd_t *prog, int len,
+                           unsigned int max_cmds,
+                           script_render_fn_t render,
+                           unsigned int render_every) {
+    unsigned short counts[MAX_DEPTH]; // iterations left in each REPEAT
+    int depth = 0;
+    script_result_t result = {SCRIPT_DONE, 0};
+    unsigned int cmds = 0;
+    int pc = 0;
+
+    while (pc < len) {
+        const script_cmd_t *cmd = &prog[pc];
+
+        // counting every command also stops empty endless loops
+        if (cmds++ == max_cmds) {
+            result.status = SCRIPT_LIMIT;
+            break;
+        }
+
+        if (cmd->op == SCRIPT_MOVE || cmd->op == SCRIPT_TURN_LEFT) {
+            int sim = karel_sim_step(cmd->op == SCRIPT_MOVE ? MOVE_FORWARD : TURN_LEFT);
+            result.steps++;
+
+            if (render && render_every && result.steps % render_every == 0) {
+                render(karel_sim_position());
+            }
+            if (sim == SIM_BLOCKED) {
+                result.status = SCRIPT_BLOCKED;
+                break;
+            } else if (sim == SIM_FINISHED) {
+                result.status = SCRIPT_FINISHED;
+                break;
+            }
+            pc++;
+
+        } else if (cmd->op == SCRIPT_REPEAT) {
+            if (cmd->arg == 0) {
+                pc = cmd->jump;
+            } else {
+                counts[depth++] = cmd->arg;
+                pc++;
+            }
+
+        } else if (cmd->op == SCRIPT_WHILE) {
+            pc = check_condition(cmd->arg) ? pc + 1 : cmd->jump;
+
+        } else if (cmd->op == SCRIPT_END) {
+            const script_cmd_t *opener = &prog[cmd->jump];
+
+            if (opener->op == SCRIPT_WHILE) {
+                pc = cmd->jump; // check the condition again
+            } else if (--counts[depth - 1] > 0) {
+                pc = cmd->jump + 1;
+            } else {
+                depth--;
+                pc++;
+            }
+
+        } else {
+            pc++;
+        }
+    }
+
+    if (render) {
+        render(karel_sim_position());
+    }
+    return result;
+}
@@ -0,0 +1,217 @@
+
+/*
+ * FILENAME: sensor_fifo.c
+ * ------------------------------------------------
+ * The chip stores each sample as six 16-bit words,
+ * gyroscope x, y and z then accelerometer x, y and z,
+ * and reports which of the six is read next. Reading
+ * FIFO_DATA_OUT_H moves the chip on to the next word
+ * and back to FIFO_DATA_OUT_L, so one long read at
+ * FIFO_DATA_OUT_L returns word after word.
+ *
+ * A drain is a chain of queued I2C transfers, each
+ * started from the one before's done function, so
+ * once interrupts are on (see i2c.h) it runs in the
+ * background and only the ring's tail moves under
+ * the caller.
+ */
+
+#include "sensor_fifo.h"
+#include "LSM6DS33.h"
+#include "i2c.h"
+
+#define FIFO_WORDS 4096 // 8 KB on the chip
+#define WORDS_PER_SAMPLE 6
+#define BYTES_PER_SAMPLE (WORDS_PER_SAMPLE * 2)
+
+// samples read from the chip in one transfer
+#define DRAIN_CHUNK 16
+
+// FIFO_CTRL5
+#define FIFO_MODE_BYPASS     0x0
+#define FIFO_MODE_CONTINUOUS 0x6
+#define ODR_FIFO_SHIFT       3
+
+// FIFO_CTRL3: gyroscope and accelerometer in the FIFO, no decimation
+#define DEC_GYRO_SHIFT 3
+#define DEC_NONE       1
+
+// FIFO_STATUS2
+#define STATUS2_OVER_RUN  0x40
+#define STATUS2_FULL      0x20
+#define STATUS2_DIFF_HIGH 0x0f
+
+static sensor_sample_t ring[SENSOR_RING_SIZE];
+static unsigned int head;          // next sample popped
+static volatile unsigned int tail; // next sample drained
+static int overruns;
+
+// the drain under way
+static volatile int draining;
+static volatile int moved;   // samples moved into the ring
+static int samples_left;     // samples still to read from the chip
+static int chunk;            // samples in the read under way
+static i2c_xfer_t xfer;
+static unsigned char reg_byte;
+static unsigned char status[4]; // FIFO_STATUS1 to FIFO_STATUS4
+static unsigned char data[DRAIN_CHUNK * BYTES_PER_SAMPLE];
+static sensor_drain_fn_t drain_handler;
+
+void sensor_fifo_start(int rate, int watermark) {
+    int words = watermark * WORDS_PER_SAMPLE;
+
+    // going through bypass mode empties the chip's FIFO
+    lsm6ds33_write_reg(FIFO_CTRL5, FIFO_MODE_BYPASS);
+    lsm6ds33_write_reg(FIFO_CTRL1, words & 0xff);
+    lsm6ds33_write_reg(FIFO_CTRL2, (words >> 8) & 0x0f);
+    lsm6ds33_write_reg(FIFO_CTRL3, DEC_NONE << DEC_GYRO_SHIFT | DEC_NONE);
+    lsm6ds33_write_reg(FIFO_CTRL5, rate << ODR_FIFO_SHIFT | FIFO_MODE_CONTINUOUS);
+
+    head = tail = 0;
+    overruns = 0;
+    draining = 0;
+}
+
+void sensor_fifo_stop(void) {
+    lsm6ds33_write_reg(FIFO_CTRL5, FIFO_MODE_BYPASS);
+}
+
+// ends the drain under way and tells the handler
+static void drain_done(void) {
+    draining = 0;
+    if (drain_handler) {
+        drain_handler();
+    }
+}
+
+// queues a read of len bytes from the chip starting at reg
+static int read_regs(unsigned char reg, int len, i2c_done_fn_t done) {
+    reg_byte = reg;
+    xfer.address = lsm6ds33_address;
+    xfer.write = &reg_byte;
+    xfer.write_len = 1;
+    xfer.read = reg == FIFO_STATUS1 ? status : data;
+    xfer.read_len = len;
+    xfer.done = done;
+    xfer.aux = 0;
+    return i2c_submit(&xfer);
+}
+
+static void chunk_read(int result, void *aux);
+
+static void read_chunk(void) {
+    chunk = samples_left < DRAIN_CHUNK ? samples_left : DRAIN_CHUNK;
+    if (chunk == 0 || !read_regs(FIFO_DATA_OUT_L, chunk * BYTES_PER_SAMPLE, chunk_read)) {
+        drain_done();
+    }
+}
+
+static void chunk_read(int result, void *aux) {
+    if (result != I2C_OK) {
+        drain_done();
+        return;
+    }
+    for (int i = 0; i < chunk; i++) {
+        sensor_sample_t *sample = &ring[tail % SENSOR_RING_SIZE];
+        lsm6ds33_unpack_xyz(data + i * BYTES_PER_SAMPLE, sample->gyro);
+        lsm6ds33_unpack_xyz(data + i * BYTES_PER_SAMPLE + 6, sample->accel);
+        tail++;
+    }
+    moved += chunk;
+    samples_left -= chunk;
+    read_chunk();
+}
+
+// reads the complete samples in words words
+static void read_samples(int words) {
+    int samples = words / WORDS_PER_SAMPLE;
+    int space = SENSOR_RING_SIZE - (tail - head);
+    if (samples > space) {
+        samples = space; // the rest waits in the chip
+    }
+    samples_left = samples;
+    read_chunk();
+}
+
+// words left after the skipped part of a sample
+static int words_after_skip;
+
+static void skipped_read(int result, void *aux) {
+    if (result != I2C_OK) {
+        drain_done();
+        return;
+    }
+    read_samples(words_after_skip);
+}
+
+static void status_read(int result, void *aux) {
+    if (result != I2C_OK) {
+        drain_done();
+        return;
+    }
+    int words = status[0] | (status[1] & STATUS2_DIFF_HIGH) << 8;
+    if (status[1] & STATUS2_FULL) {
+        words = FIFO_WORDS; // one more than the count can hold
+    }
+    int pattern = status[2] | (status[3] & 0x3) << 8;
+    if (status[1] & STATUS2_OVER_RUN) {
+        overruns++;
+    }
+
+    // skip the rest of a sample that was partly read
+    if (pattern != 0 && words > 0) {
+        int skip = WORDS_PER_SAMPLE - pattern;
+        if (skip > words) skip = words;
+        words_after_skip = words - skip;
+        if (!read_regs(FIFO_DATA_OUT_L, skip * 2, skipped_read)) {
+            drain_done();
+        }
+        return;
+    }
+    read_samples(words);
+}
+
+int sensor_fifo_drain_start(void) {
+    if (draining) return 0;
+
+    draining = 1;
+    moved = 0;
+    if (!read_regs(FIFO_STATUS1, sizeof(status), status_read)) {
+        draining = 0; // the I2C queue is full, try again later
+        return 0;
+    }
+    return 1;
+}
+
+void sensor_fifo_set_drain_handler(sensor_drain_fn_t fn) {
+    drain_handler = fn;
+}
+
+int sensor_fifo_draining(void) {
+    return draining;
+}
+
+int sensor_fifo_drain(void) {
+    while (draining) {
+        i2c_check_timeouts(); // let an earlier drain finish first
+    }
+    sensor_fifo_drain_start();
+    while (draining) {
+        i2c_check_timeouts();
+    }
+    return moved;
+}
+
+int sensor_fifo_pop(sensor_sample_t *sample) {
+    if (head == tail) return 0;
+    *sample = ring[head++ % SENSOR_RING_SIZE];
+    return 1;
+}
+
+int sensor_fifo_available(void) {
+    return tail - head;
+}
+
+int sensor_fifo_overruns(void) {
+    return overruns;
+}
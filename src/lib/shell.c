@@ -10,7 +10,8 @@
  * This file also implements the extension, where the user can move 
  * the cursor left or right using the left/right arrows respectively,
  * and can use the "history" command to see past commands. It also 
- * implements the profiler extension.
+ * implements the profiler extension, and the "karel" command, which
+ * compiles and runs a Karel program typed into the shell.
  *
  * Happy typing!
  */
@@ -22,9 +23,10 @@
 #include "malloc.h"
 #include "pi.h"
 #include "ps2_keys.h"
-#include "armtimer.h"
-#include "interrupts.h"
 #include "backtrace.h"
+#include "timer.h"
+#include "board.h"
+#include "karel_vm.h"
 
 // for profiler extension
 extern unsigned int __text_end__;
@@ -33,7 +35,6 @@ static unsigned int text_start = 0x8000;
 
 const int NUM_INSTR = 20; // the number of instructions to print with the most hospot counts
 static unsigned int *counts = NULL; // pointer to array of hotspot counts
-const unsigned int COUNT_PERIOD = 1000; // time between interrupt counts
 
 #define LINE_LEN 80
 const unsigned int MAX_TOKENS = LINE_LEN / 2; // max when each command/arg
@@ -49,6 +50,7 @@ unsigned int num_history= 0; // # of calls saved in history
 
 int cmd_history(int argc, const char *argv[]);
 int cmd_profile(int argc, const char *argv[]);
+int cmd_karel(int argc, const char *argv[]);
 
 // NOTE TO STUDENTS: It will greatly help our grading if you use the following
 // format strings in the following contexts. We provide the format strings; you
@@ -73,6 +75,7 @@ static const command_t commands[] = {
     {"poke", "[address] [value] stores value at address", cmd_poke},
     {"history", "prints out the commands typed till now", cmd_history},
     {"profile", "[on | off] shows the hotspots in the code", cmd_profile},
+    {"karel", "<program> compiles and runs a Karel program", cmd_karel},
 };
 
 const unsigned int NUM_COMMANDS = sizeof(commands) / sizeof(command_t);
@@ -215,10 +218,10 @@ int cmd_history(int argc, const char *argv[]) {
  * Handler function to interrupt program and incement
  * the number of counts
  */
-void get_counts(unsigned int pc, void *aux_data) {
+void get_counts(unsigned int pc) {
 
-    if (armtimer_check_and_clear_interrupt()) {
-        counts[pc - text_start]++;
+    if (pc >= text_start && pc < text_end) {
+        counts[(pc - text_start) / 4]++;
     }
 }
 
@@ -276,6 +279,10 @@ int cmd_profile(int argc, const char *argv[]) {
 
         if (strcmp(argv[1], "on") == 0) {
 
+            if (counts) {
+                shell_printf("error: profile is already on\n");
+                return 1;
+            }
             counts = (unsigned int *)malloc(text_end - text_start);
 
             // zero out counts
@@ -283,17 +290,23 @@ int cmd_profile(int argc, const char *argv[]) {
                 counts[i] = 0;
             }
 
-            // start timer
-            armtimer_enable();
+            // sample on the timer's wake interrupt, every TIMER_WAKE_US
+            timer_set_tick_handler(get_counts);
 
         } else if (strcmp(argv[1], "off") == 0) {
 
-            // stop counts
-            armtimer_disable();
-            free(counts);
-            
+            if (!counts) {
+                shell_printf("error: profile is not on\n");
+                return 1;
+            }
+
+            // stop counts; the timer keeps running to wake timer_idle
+            timer_set_tick_handler(NULL);
+
             // print out results
             print_hotspots();
+            free(counts);
+            counts = NULL;
 
         } else {
             shell_printf("error: argument for profiel should be 'on' or 'off'\n");
@@ -304,16 +317,70 @@ int cmd_profile(int argc, const char *argv[]) {
 }
 
 
+// most instructions a program typed into the shell may run
+#define KAREL_MAX_INSTRUCTIONS 100000000
+
+static const char *const karel_status[] = {
+    "halted", "reached the goal", "was blocked", "ran too long",
+    "nested too deeply",
+};
+
+static void draw_karel(pos_t karel) {
+    draw_board(karel.x, karel.y, karel.dir);
+}
+
+/*
+ * Compiles the rest of the line as a Karel program (see
+ * karel_vm.h) and runs it from Karel's current position,
+ * drawing the board once it stops. Prints how many
+ * instructions ran and how fast.
+ *
+ * @returns 0 if the program compiled, 1 otherwise
+ * @precon  the board must be initialized
+ */
+int cmd_karel(int argc, const char *argv[]) {
+    if (argc == 1) {
+        shell_printf("error: karel needs a program\n");
+        return 1;
+    }
+
+    char source[LINE_LEN];
+    source[0] = '\0';
+    for (int i = 1; i < argc; i++) {
+        strlcat(source, argv[i], sizeof(source));
+        strlcat(source, " ", sizeof(source));
+    }
+
+    int entry = karel_compile(source);
+    if (entry < 0) {
+        shell_printf("error: %s\n", karel_compile_error());
+        return 1;
+    }
+
+    unsigned long long start = timer_get_ticks64();
+    karel_vm_result_t result = karel_vm_run(karel_bytecode(), entry,
+                                            KAREL_MAX_INSTRUCTIONS, draw_karel, 0);
+    unsigned int elapsed = timer_get_ticks64() - start;
+
+    shell_printf("Karel %s: %d instructions, %d actions in %d us",
+                 karel_status[result.status], result.instructions,
+                 result.actions, elapsed);
+    if (elapsed > 0) {
+        unsigned int per_ms = (unsigned long long) result.instructions * 1000 / elapsed;
+        shell_printf(" (%d instructions/ms)", per_ms);
+    }
+    shell_printf("\n");
+    return 0;
+}
+
+
 void shell_init(input_fn_t read_fn, formatted_fn_t print_fn)
 {
     shell_read = read_fn;
     shell_printf = print_fn;
 
-    // configure armtimer for profile
-    armtimer_init(COUNT_PERIOD);
-    armtimer_enable_interrupts();
-    interrupts_register_handler(INTERRUPTS_BASIC_ARM_TIMER_IRQ, get_counts, NULL);
-    interrupts_enable_source(INTERRUPTS_BASIC_ARM_TIMER_IRQ);
+    // the profiler samples on the timer's interrupt
+    timer_init();
 }
 
 void shell_bell(void)
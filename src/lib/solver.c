@@ -0,0 +1,220 @@
+
+/*
+ * FILENAME: solver.c
+ * ------------------------------------------------
+ * A* search over Karel's (x, y, direction) states.
+ *
+ * All memory is allocated statically for the largest
+ * board, and the per-state bookkeeping is tagged with
+ * a search number so nothing has to be cleared between
+ * searches.
+ */
+
+#include "solver.h"
+#include "board.h"
+#include "accel.h"
+
+#define MAX_STATES (BOARD_MAX_ROWS * BOARD_MAX_COLS * 4)
+
+// every state has at most two predecessors (a move and
+// a turn), so it can be pushed at most twice
+#define MAX_OPEN (2 * MAX_STATES + 1)
+
+#define NO_PARENT -1
+
+struct state_info {
+    unsigned int search; // search this info belongs to
+    unsigned int g;      // cost from the start
+    int parent;          // previous state on best path
+    int closed;          // already expanded
+};
+
+struct open_entry {
+    unsigned int f;
+    unsigned int g;
+    int state;
+};
+
+static struct state_info info[MAX_STATES];
+static struct open_entry open_list[MAX_OPEN];
+static int open_size;
+static unsigned int search_id;
+static solver_stats_t stats;
+
+static int num_cols;
+static int goal_x, goal_y;
+
+/*
+ * Number of left turns needed to go from facing
+ * direction `from` to facing direction `to`
+ */
+static inline int left_turns(int from, int to) {
+    return (to - from + 4) % 4;
+}
+
+/*
+ * Manhattan distance to the goal plus the fewest left
+ * turns needed to face every direction Karel still has
+ * to travel in. Never overestimates, so A* stays exact.
+ */
+static unsigned int heuristic(int x, int y, int dir) {
+    int dx = goal_x - x;
+    int dy = goal_y - y;
+    int h_dir = dx > 0 ? EAST : WEST;
+    int v_dir = dy > 0 ? SOUTH : NORTH;
+    unsigned int dist = (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+
+    if (dx == 0 && dy == 0) {
+        return 0;
+    } else if (dy == 0) {
+        return dist + left_turns(dir, h_dir);
+    } else if (dx == 0) {
+        return dist + left_turns(dir, v_dir);
+    }
+
+    int h_first = left_turns(dir, h_dir) + left_turns(h_dir, v_dir);
+    int v_first = left_turns(dir, v_dir) + left_turns(v_dir, h_dir);
+    return dist + (h_first < v_first ? h_first : v_first);
+}
+
+/*
+ * Orders open list entries by f, breaking ties
+ * towards the larger g (deeper states)
+ */
+static inline int entry_less(const struct open_entry *a,
+                             const struct open_entry *b) {
+    return a->f < b->f || (a->f == b->f && a->g > b->g);
+}
+
+static void open_push(unsigned int f, unsigned int g, int state) {
+    int i = open_size++;
+    struct open_entry entry = {f, g, state};
+
+    // sift up
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!entry_less(&entry, &open_list[parent])) break;
+        open_list[i] = open_list[parent];
+        i = parent;
+    }
+    open_list[i] = entry;
+    stats.pushed++;
+}
+
+static struct open_entry open_pop(void) {
+    struct open_entry top = open_list[0];
+    struct open_entry last = open_list[--open_size];
+    int i = 0;
+
+    // sift down
+    while (1) {
+        int child = 2 * i + 1;
+        if (child >= open_size) break;
+        if (child + 1 < open_size
+                && entry_less(&open_list[child + 1], &open_list[child])) {
+            child++;
+        }
+        if (!entry_less(&open_list[child], &last)) break;
+        open_list[i] = open_list[child];
+        i = child;
+    }
+    open_list[i] = last;
+    return top;
+}
+
+static inline int state_of(int x, int y, int dir) {
+    return (y * num_cols + x) * 4 + dir;
+}
+
+/*
+ * Updates the cost of a state if the new path to it
+ * is cheaper, and puts it on the open list
+ */
+static void relax(int state, int x, int y, int dir,
+                  unsigned int g, int parent) {
+    struct state_info *s = &info[state];
+
+    if (s->search != search_id) {
+        *s = (struct state_info) {search_id, g, parent, 0};
+    } else if (s->closed || g >= s->g) {
+        return;
+    } else {
+        s->g = g;
+        s->parent = parent;
+    }
+    open_push(g + heuristic(x, y, dir), g, state);
+}
+
+/*
+ * Walks back from the goal state and writes the
+ * actions taken into path
+ */
+static void build_path(int state, unsigned char *path, int max_len) {
+    while (info[state].parent != NO_PARENT) {
+        int parent = info[state].parent;
+        int step = info[parent].g; // index of this action in path
+
+        if (step < max_len) {
+            // same cell means Karel turned
+            path[step] = (parent / 4 == state / 4) ? TURN_LEFT : MOVE_FORWARD;
+        }
+        state = parent;
+    }
+}
+
+int solver_find_path(pos_t start, int gx, int gy,
+                     unsigned char *path, int max_len) {
+    const board_config_t *config = board_get_config();
+    num_cols = config->num_cols;
+    goal_x = gx;
+    goal_y = gy;
+
+    stats = (solver_stats_t) {0, 0};
+    open_size = 0;
+
+    // a new search id invalidates all old state info
+    if (++search_id == 0) {
+        for (int i = 0; i < MAX_STATES; i++) info[i].search = 0;
+        search_id = 1;
+    }
+
+    relax(state_of(start.x, start.y, start.dir), start.x, start.y,
+          start.dir, 0, NO_PARENT);
+
+    while (open_size > 0) {
+        struct open_entry top = open_pop();
+        struct state_info *s = &info[top.state];
+
+        // skip stale entries
+        if (s->closed || top.g != s->g) continue;
+        s->closed = 1;
+        stats.expanded++;
+
+        int cell = top.state / 4;
+        int dir = top.state % 4;
+        int x = cell % num_cols;
+        int y = cell / num_cols;
+
+        if (x == goal_x && y == goal_y) {
+            build_path(top.state, path, max_len);
+            return s->g;
+        }
+
+        // turn_left()
+        int left = (dir + 1) % 4;
+        relax(state_of(x, y, left), x, y, left, s->g + 1, top.state);
+
+        // move()
+        if (board_can_move(x, y, dir)) {
+            int nx = x + (dir == EAST) - (dir == WEST);
+            int ny = y + (dir == SOUTH) - (dir == NORTH);
+            relax(state_of(nx, ny, dir), nx, ny, dir, s->g + 1, top.state);
+        }
+    }
+
+    return -1;
+}
+
+solver_stats_t solver_get_stats(void) {
+    return stats;
+}
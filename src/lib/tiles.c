@@ -0,0 +1,183 @@
+
+/*
+ * FILENAME: tiles.c
+ * ------------------------------------------------
+ * Indexes the special tiles of the board. Cells
+ * with beepers are kept both in a list (to enumerate
+ * them) and in a plane of per-cell counts (to look
+ * them up in O(1)). Each cell also remembers its
+ * slot in the list, so a cell that runs out of
+ * beepers leaves the list in O(1) as well.
+ */
+
+#include "tiles.h"
+#include "board.h"
+
+// most tiles of one kind we keep track of
+#define MAX_TILES 1024
+
+#define MAX_CELLS (BOARD_MAX_ROWS * BOARD_MAX_COLS)
+
+// most beepers one cell can hold
+#define MAX_BEEPERS_PER_CELL 255
+
+struct tile_list {
+    tile_pos_t pos[MAX_TILES];
+    int count;
+};
+
+static struct tile_list beepers;
+static struct tile_list pats;
+static struct tile_list julies;
+static unsigned char beeper_counts[MAX_CELLS];
+static unsigned short beeper_slot[MAX_CELLS]; // index into beepers
+static int total_beepers;
+
+static struct tile_list *list_for(int kind) {
+    if (kind == BEEPER) return &beepers;
+    if (kind == PAT) return &pats;
+    if (kind == JULIE) return &julies;
+    return 0;
+}
+
+static inline unsigned int cell_index(int x, int y) {
+    return y * BOARD_MAX_COLS + x;
+}
+
+/*
+ * Adds a tile to its list. Tiles past MAX_TILES
+ * are dropped.
+ */
+static void add_tile(struct tile_list *list, int x, int y) {
+    if (list->count < MAX_TILES) {
+        list->pos[list->count++] = (tile_pos_t) {x, y};
+    }
+}
+
+/*
+ * Puts count beepers on an empty cell, adding it
+ * to the list. Returns 0 if the list is full.
+ */
+static int add_beeper_cell(int x, int y, int count) {
+    if (beepers.count == MAX_TILES) return 0;
+
+    unsigned int idx = cell_index(x, y);
+    beeper_slot[idx] = beepers.count;
+    add_tile(&beepers, x, y);
+    beeper_counts[idx] = count;
+    total_beepers += count;
+    return 1;
+}
+
+// empties a cell of beepers, taking it off the list
+static void remove_beeper_cell(int x, int y) {
+    unsigned int idx = cell_index(x, y);
+    int slot = beeper_slot[idx];
+    tile_pos_t last = beepers.pos[--beepers.count];
+
+    beepers.pos[slot] = last;
+    beeper_slot[cell_index(last.x, last.y)] = slot;
+    total_beepers -= beeper_counts[idx];
+    beeper_counts[idx] = 0;
+}
+
+void tiles_build(const char *board[], int nrows, int ncols) {
+
+    // only clear the counts we set last time
+    for (int i = 0; i < beepers.count; i++) {
+        beeper_counts[cell_index(beepers.pos[i].x, beepers.pos[i].y)] = 0;
+    }
+    beepers.count = pats.count = julies.count = 0;
+    total_beepers = 0;
+
+    for (int y = 0; y < nrows; y++) {
+        for (int x = 0; x < ncols; x++) {
+            if (board[y][x] == BEEPER) {
+                add_beeper_cell(x, y, 1);
+            } else if (list_for(board[y][x])) {
+                add_tile(list_for(board[y][x]), x, y);
+            }
+        }
+    }
+}
+
+/*
+ * Removes the tile at (x, y) from its list by moving
+ * the last tile into its slot
+ */
+static void remove_tile(struct tile_list *list, int x, int y) {
+    for (int i = 0; i < list->count; i++) {
+        if (list->pos[i].x == x && list->pos[i].y == y) {
+            list->pos[i] = list->pos[--list->count];
+            return;
+        }
+    }
+}
+
+void tiles_update(int x, int y, int old_tile, int new_tile) {
+    unsigned int idx = cell_index(x, y);
+
+    if (old_tile == BEEPER) {
+        if (beeper_counts[idx] > 0) remove_beeper_cell(x, y);
+    } else if (list_for(old_tile)) {
+        remove_tile(list_for(old_tile), x, y);
+    }
+
+    if (new_tile == BEEPER) {
+        if (beeper_counts[idx] == 0) add_beeper_cell(x, y, 1);
+    } else if (list_for(new_tile)) {
+        add_tile(list_for(new_tile), x, y);
+    }
+}
+
+int tiles_has_beeper(int x, int y) {
+    return tiles_beepers(x, y) > 0;
+}
+
+int tiles_beepers(int x, int y) {
+    if (x < 0 || x >= BOARD_MAX_COLS || y < 0 || y >= BOARD_MAX_ROWS) {
+        return 0;
+    }
+    return beeper_counts[cell_index(x, y)];
+}
+
+int tiles_total_beepers(void) {
+    return total_beepers;
+}
+
+int tiles_add_beeper(int x, int y) {
+    unsigned int idx = cell_index(x, y);
+
+    if (beeper_counts[idx] == 0) {
+        return add_beeper_cell(x, y, 1);
+    } else if (beeper_counts[idx] == MAX_BEEPERS_PER_CELL) {
+        return 0;
+    }
+    beeper_counts[idx]++;
+    total_beepers++;
+    return 1;
+}
+
+int tiles_remove_beeper(int x, int y) {
+    unsigned int idx = cell_index(x, y);
+
+    if (beeper_counts[idx] == 0) {
+        return 0;
+    } else if (beeper_counts[idx] == 1) {
+        remove_beeper_cell(x, y);
+    } else {
+        beeper_counts[idx]--;
+        total_beepers--;
+    }
+    return 1;
+}
+
+int tiles_count(int kind) {
+    struct tile_list *list = list_for(kind);
+    return list ? list->count : 0;
+}
+
+const tile_pos_t *tiles_list(int kind) {
+    struct tile_list *list = list_for(kind);
+    return list ? list->pos : 0;
+}
@@ -6,9 +6,39 @@
  * based on the internal ARM tick counter
  */
 #include "timer.h"
+#include "armtimer.h"
+#include "interrupts.h"
+#include "pmu.h"
+
 volatile unsigned int *CLO = (void *)0x20003004;
+volatile unsigned int *CHI = (void *)0x20003008;
+
+static int wake_enabled;
+static timer_tick_fn_t tick_handler;
+
+// the interrupt wakes the processor, and lets a profiler see where it was
+static void wake(unsigned int pc, void *aux_data) {
+    if (armtimer_check_and_clear_interrupt() && tick_handler) {
+        tick_handler(pc);
+    }
+}
+
+void timer_set_tick_handler(timer_tick_fn_t fn) {
+    tick_handler = fn;
+}
 
 void timer_init(void) {
+    if (wake_enabled) return;
+
+    interrupts_init();
+    armtimer_init(TIMER_WAKE_US);
+    armtimer_enable();
+    armtimer_enable_interrupts();
+    interrupts_register_handler(INTERRUPTS_BASIC_ARM_TIMER_IRQ, wake, NULL);
+    interrupts_enable_source(INTERRUPTS_BASIC_ARM_TIMER_IRQ);
+    interrupts_global_enable();
+    armv6_pmcr_write(ARMV6_PMCR_ENABLE | ARMV6_PMCR_CCOUNT_RESET);
+    wake_enabled = 1;
 }
 
 /* This function returns the value of the tick counter
@@ -19,6 +49,27 @@ unsigned int timer_get_ticks(void) {
     return time;
 }
 
+unsigned long long timer_get_ticks64(void) {
+    unsigned int hi = *CHI;
+    unsigned int lo = *CLO;
+    unsigned int hi_again = *CHI;
+
+    if (hi_again != hi) {
+        lo = *CLO; // CLO wrapped between the reads
+    }
+    return (unsigned long long) hi_again << 32 | lo;
+}
+
+unsigned int timer_get_cycles(void) {
+    return armv6pmu_read_counter(ARMV6_CYCLE_COUNTER);
+}
+
+void timer_idle(unsigned int until_us) {
+    if (wake_enabled && (int) (until_us - timer_get_ticks()) > (int) TIMER_WAKE_US) {
+        __asm__ volatile("mcr p15, 0, %0, c7, c0, 4" : : "r" (0)); // wait for interrupt
+    }
+}
+
 void timer_delay_us(unsigned int usecs) {
     unsigned int start = timer_get_ticks();
     while (timer_get_ticks() - start < usecs) { /* spin */ }
@@ -2,10 +2,27 @@
 #include "uart.h"
 #include "board.h"
 #include "accel.h"
+#include "LSM6DS33.h"
+#include "i2c.h"
 #include "timer.h"
 #include "gl.h"
 #include "karel_world.h"
 #include "game.h"
+#include "tiles.h"
+#include "solver.h"
+#include "distfield.h"
+#include "maze.h"
+#include "script.h"
+#include "karel_vm.h"
+#include "replay.h"
+#include "journal.h"
+#include "sched.h"
+#include "fixed.h"
+#include "calibration.h"
+#include "move_queue.h"
+#include "input.h"
+#include "assert.h"
+#include "strings.h"
 
 /* 
  * Tests basic board
@@ -56,9 +73,745 @@ void test_complex_board(void) {
     draw_board(0, 0, 0);
 }
 
+/*
+ * Draws every frame of a move, as fast as they can be drawn
+ */
+static void animate_move(int from_x, int from_y, int from_dir,
+                         int to_x, int to_y, int to_dir) {
+    unsigned int start = timer_get_ticks();
+    for (int progress = 0; progress <= KAREL_MOVE_STEPS; progress += 16) {
+        draw_karel_move(from_x, from_y, from_dir, to_x, to_y, to_dir, progress);
+    }
+    printf("animated move in %d us\n", timer_get_ticks() - start);
+}
+
+/*
+ * The moves of test_board, animated
+ */
+void test_board_animation(void) {
+    const char *board[3] =
+    {
+        "---",
+        "-w-",
+        "--b",
+    };
+
+    board_init(board, 3, 3);
+    draw_board(0, 0, EAST);
+    animate_move(0, 0, EAST, 1, 0, EAST);   // 1 step east
+    animate_move(1, 0, EAST, 1, 0, NORTH);  // turn left
+    animate_move(1, 0, NORTH, 1, 0, WEST);  // turn left again
+    animate_move(1, 0, WEST, 0, 0, WEST);   // 1 step west
+    animate_move(0, 0, WEST, 0, 0, NORTH);  // turn right
+    animate_move(0, 0, NORTH, 0, 0, WEST);  // and back
+}
+
+void test_walls(void) {
+
+    const char *board[3] = 
+    {
+        "-s-",
+        "-c-",
+        "--w",
+    };
+    board_init(board, 3, 3);
+
+    // a wall is seen from both cells it separates
+    assert(!board_can_move(1, 0, SOUTH) && !board_can_move(1, 1, NORTH));
+    assert(!board_can_move(2, 2, WEST) && !board_can_move(1, 2, EAST));
+
+    // the corner cell has walls south and west
+    assert(board_walls(1, 1) == (WALL_BIT(NORTH) | WALL_BIT(SOUTH) | WALL_BIT(WEST)));
+    assert(!board_can_move(1, 1, WEST) && !board_can_move(0, 1, EAST));
+    assert(!board_can_move(1, 2, NORTH));
+    assert(board_can_move(1, 1, EAST) && board_can_move(2, 1, WEST));
+
+    // the edges are walls too
+    assert(!board_can_move(0, 0, NORTH) && !board_can_move(0, 0, WEST));
+    assert(!board_can_move(2, 2, EAST) && !board_can_move(2, 2, SOUTH));
+    assert(board_walls(0, 0) == (WALL_BIT(NORTH) | WALL_BIT(WEST)));
+
+    board_set_wall(1, 1, SOUTH, 0);
+    assert(board_can_move(1, 2, NORTH));
+    board_set_wall(0, 0, WEST, 0); // stays
+    assert(!board_can_move(0, 0, WEST));
+    board_set_wall(0, 0, EAST, 1);
+    assert(!board_can_move(1, 0, WEST));
+
+    // replacing a wall tile takes its walls away
+    board_set_tile(1, 0, BEEPER);
+    assert(board_can_move(1, 0, SOUTH) && tiles_has_beeper(1, 0));
+}
+
+void test_tiles(void) {
+
+    const char *board[3] = 
+    {
+        "b-p",
+        "-w-",
+        "z-b",
+    };
+
+    tiles_build(board, 3, 3);
+    assert(tiles_count(BEEPER) == 2);
+    assert(tiles_count(PAT) == 1);
+    assert(tiles_count(JULIE) == 1);
+    assert(tiles_has_beeper(0, 0));
+    assert(tiles_has_beeper(2, 2));
+    assert(!tiles_has_beeper(1, 1));
+    assert(!tiles_has_beeper(-1, 0));
+
+    // rebuilding forgets the old beepers
+    const char *empty[1] = {"---"};
+    tiles_build(empty, 1, 3);
+    assert(tiles_count(BEEPER) == 0);
+    assert(!tiles_has_beeper(0, 0));
+}
+
+void test_solver(void) {
+
+    const char *board[3] = 
+    {
+        "b--",
+        "sw-",
+        "---",
+    };
+
+    board_init(board, 3, 3);
+    unsigned char path[16];
+
+    // east, turn left, north, north, turn left, west
+    int len = solver_find_path((pos_t) {0, 2, EAST}, 0, 0, path, 16);
+    assert(len == 6);
+    assert(path[0] == MOVE_FORWARD && path[1] == TURN_LEFT);
+    assert(path[4] == TURN_LEFT && path[5] == MOVE_FORWARD);
+
+    // only a short prefix is written, full length is still returned
+    len = solver_find_path((pos_t) {0, 2, EAST}, 0, 0, path, 2);
+    assert(len == 6);
+
+    // already there
+    assert(solver_find_path((pos_t) {0, 0, WEST}, 0, 0, path, 16) == 0);
+}
+
+void test_distfield(void) {
+
+    const char *board[3] = 
+    {
+        "b--",
+        "sw-",
+        "---",
+    };
+
+    board_init(board, 3, 3);
+    distfield_compute();
+
+    // same path the solver finds
+    assert(distfield_get((pos_t) {0, 2, EAST}) == 6);
+    assert(distfield_next_move((pos_t) {0, 2, EAST}) == MOVE_FORWARD);
+    assert(distfield_get((pos_t) {0, 0, SOUTH}) == 0);
+    assert(distfield_next_move((pos_t) {0, 0, SOUTH}) == -1);
+
+    // wall off the beeper, then open the south side
+    board_set_tile(1, 0, WEST_WALL);
+    distfield_update(1, 0);
+    assert(distfield_get((pos_t) {0, 2, EAST}) == -1);
+
+    board_set_tile(0, 1, FREE);
+    distfield_update(0, 1);
+    assert(distfield_get((pos_t) {0, 2, NORTH}) == 2);
+
+    // a new beeper next to Karel
+    board_set_tile(1, 2, BEEPER);
+    distfield_update(1, 2);
+    assert(distfield_get((pos_t) {0, 2, EAST}) == 1);
+}
+
+// big empty board for benchmarks
+#define BENCH_DIM 128
+static char bench_rows[BENCH_DIM][BENCH_DIM + 1];
+static const char *bench_board[BENCH_DIM];
+
+void bench_solver(void) {
+
+    const char *names[3] = {"backtracker", "kruskal", "wilson"};
+    unsigned char path[16];
+
+    for (int algorithm = 0; algorithm < 3; algorithm++) {
+        maze_generate(BENCH_DIM, BENCH_DIM, 107, algorithm);
+
+        unsigned int start = timer_get_ticks();
+        int len = solver_find_path((pos_t) {0, BENCH_DIM - 1, EAST},
+                                   BENCH_DIM - 1, 0, path, 16);
+        unsigned int elapsed = timer_get_ticks() - start;
+
+        solver_stats_t stats = solver_get_stats();
+        printf("solver: %dx%d %s maze, path of %d in %d us, "
+               "%d states expanded\n", BENCH_DIM, BENCH_DIM, names[algorithm],
+               len, elapsed, stats.expanded);
+    }
+}
+
+void bench_distfield(void) {
+
+    for (int y = 0; y < BENCH_DIM; y++) {
+        memset(bench_rows[y], FREE, BENCH_DIM);
+        bench_board[y] = bench_rows[y];
+    }
+    bench_rows[0][BENCH_DIM - 1] = BEEPER;
+    board_init(bench_board, BENCH_DIM, 3);
+
+    unsigned int start = timer_get_ticks();
+    distfield_compute();
+    unsigned int compute_us = timer_get_ticks() - start;
+
+    // a wall next to the beeper changes many distances
+    start = timer_get_ticks();
+    board_set_tile(BENCH_DIM - 2, 1, WEST_WALL);
+    distfield_update(BENCH_DIM - 2, 1);
+    unsigned int update_us = timer_get_ticks() - start;
+
+    start = timer_get_ticks();
+    int total = 0;
+    for (int y = 0; y < BENCH_DIM; y++) {
+        for (int x = 0; x < BENCH_DIM; x++) {
+            total += distfield_get((pos_t) {x, y, EAST});
+        }
+    }
+    unsigned int query_us = timer_get_ticks() - start;
+
+    printf("distfield: %dx%d compute %d us, update %d us, "
+           "%d queries %d us (sum %d)\n", BENCH_DIM, BENCH_DIM, compute_us,
+           update_us, BENCH_DIM * BENCH_DIM, query_us, total);
+}
+
+void test_maze(void) {
+
+    for (int algorithm = 0; algorithm < 3; algorithm++) {
+        maze_generate(12, 9, 42, algorithm);
+        const board_config_t *config = board_get_config();
+        assert(config->num_rows == 12 && config->num_cols == 9);
+        assert(tiles_has_beeper(8, 0));
+
+        // every cell can reach the beeper
+        distfield_compute();
+        for (int y = 0; y < 12; y++) {
+            for (int x = 0; x < 9; x++) {
+                assert(distfield_get((pos_t) {x, y, EAST}) >= 0);
+            }
+        }
+
+        // same seed, same maze, wall for wall
+        int walls[12][9];
+        for (int y = 0; y < 12; y++) {
+            for (int x = 0; x < 9; x++) {
+                walls[y][x] = board_walls(x, y);
+            }
+        }
+        maze_generate(12, 9, 42, algorithm);
+        for (int y = 0; y < 12; y++) {
+            for (int x = 0; x < 9; x++) {
+                assert(board_walls(x, y) == walls[y][x]);
+                assert(tiles_has_beeper(x, y) == (x == 8 && y == 0));
+            }
+        }
+    }
+}
+
+void bench_maze(void) {
+
+    const char *names[3] = {"backtracker", "kruskal", "wilson"};
+
+    for (int algorithm = 0; algorithm < 3; algorithm++) {
+        for (int dim = 16; dim <= BOARD_MAX_ROWS; dim *= 2) {
+            unsigned int start = timer_get_ticks();
+            maze_generate(dim, dim, 107, algorithm);
+            unsigned int elapsed = timer_get_ticks() - start;
+
+            printf("maze: %s %d cells in %d us (%d cells/ms)\n",
+                   names[algorithm], dim * dim, elapsed,
+                   elapsed ? dim * dim * 1000 / elapsed : 0);
+        }
+    }
+}
+
+void test_script(void) {
+
+    const char *board[3] = 
+    {
+        "---",
+        "---",
+        "--b",
+    };
+    board_init(board, 3, 3);
+
+    // go east until the wall, then turn right and walk to the beeper
+    script_cmd_t prog[] = {
+        {SCRIPT_WHILE, COND_FRONT_IS_CLEAR}, {SCRIPT_MOVE}, {SCRIPT_END},
+        {SCRIPT_REPEAT, 3}, {SCRIPT_TURN_LEFT}, {SCRIPT_END},
+        {SCRIPT_REPEAT, 5}, {SCRIPT_MOVE}, {SCRIPT_END},
+    };
+    int len = sizeof(prog) / sizeof(prog[0]);
+    assert(script_compile(prog, len) == 0);
+
+    karel_sim_init((pos_t) {0, 0, EAST});
+    script_result_t result = script_run(prog, len, 1000, NULL, 0);
+    assert(result.status == SCRIPT_FINISHED);
+    assert(result.steps == 7);
+
+    // starting south, the right turn faces the west edge
+    karel_sim_init((pos_t) {0, 0, SOUTH});
+    result = script_run(prog, len, 1000, NULL, 0);
+    assert(result.status == SCRIPT_BLOCKED);
+
+    // an endless loop stops at the limit
+    script_cmd_t spin[] = {
+        {SCRIPT_WHILE, COND_NOT_ON_BEEPER}, {SCRIPT_TURN_LEFT}, {SCRIPT_END},
+    };
+    assert(script_compile(spin, 3) == 0);
+    karel_sim_init((pos_t) {0, 0, EAST});
+    assert(script_run(spin, 3, 100, NULL, 0).status == SCRIPT_LIMIT);
+
+    script_cmd_t unbalanced[] = {{SCRIPT_REPEAT, 2}, {SCRIPT_MOVE}};
+    assert(script_compile(unbalanced, 2) == -1);
+}
+
+void test_karel_vm(void) {
+
+    const char *board[3] = 
+    {
+        "---",
+        "---",
+        "--b",
+    };
+    board_init(board, 3, 3);
+
+    // functions stay defined for later programs
+    assert(karel_compile("def turn_right() { repeat 3 { turn_left(); } }") >= 0);
+    int entry = karel_compile("while front_is_clear { move } turn_right "
+                              "while not beepers_present { move }");
+    assert(entry >= 0);
+
+    karel_sim_init((pos_t) {0, 0, EAST});
+    karel_vm_result_t result = karel_vm_run(karel_bytecode(), entry, 1000, NULL, 0);
+    assert(result.status == VM_FINISHED);
+    assert(result.actions == 7);
+
+    // starting south, the right turn faces the west edge
+    entry = karel_compile("while front_is_clear { move } turn_right move");
+    karel_sim_init((pos_t) {0, 0, SOUTH});
+    assert(karel_vm_run(karel_bytecode(), entry, 1000, NULL, 0).status == VM_BLOCKED);
+
+    // if/else and facing predicates
+    entry = karel_compile("if facing_north { move } else { turn_left }");
+    karel_sim_init((pos_t) {0, 0, EAST});
+    result = karel_vm_run(karel_bytecode(), entry, 1000, NULL, 0);
+    assert(result.status == VM_HALTED && result.actions == 1);
+    assert(karel_sim_position().dir == NORTH);
+
+    // endless loops and recursion are stopped
+    entry = karel_compile("while no_beepers_present { turn_left }");
+    assert(karel_vm_run(karel_bytecode(), entry, 100, NULL, 0).status == VM_LIMIT);
+    assert(karel_compile("def spin { spin }") >= 0);
+    entry = karel_compile("spin");
+    assert(karel_vm_run(karel_bytecode(), entry, 1000, NULL, 0).status == VM_STACK);
+
+    // errors leave earlier functions alone
+    assert(karel_compile("repeat 2 { move") == -1);
+    assert(karel_compile("jump") == -1);
+    assert(strcmp(karel_compile_error(), "unknown name 'jump'") == 0);
+    assert(karel_compile("if sunny { move }") == -1);
+    assert(karel_compile("turn_right") >= 0);
+}
+
+static unsigned int replay_waited_ms;
+
+static void replay_wait(unsigned int ms) {
+    replay_waited_ms += ms;
+}
+
+void test_replay(void) {
+
+    const char *board[3] = 
+    {
+        "---",
+        "---",
+        "--b",
+    };
+    board_init(board, 3, 3);
+
+    // east, east, turn right, blocked at the edge, south, south
+    pos_t start = {0, 0, EAST};
+    int moves[] = {MOVE_FORWARD, MOVE_FORWARD, TURN_LEFT, TURN_LEFT, TURN_LEFT,
+                   MOVE_FORWARD, MOVE_FORWARD};
+    replay_record_start(start, 5000);
+    unsigned int now = 5000;
+    for (int i = 0; i < 7; i++) {
+        now += 300000 + i * 100;
+        replay_record(moves[i], now);
+    }
+    assert(replay_num_moves() == 7);
+    assert(replay_size() == 14); // 300 ms needs a second byte
+
+    replay_waited_ms = 0;
+    replay_result_t result = replay_run(replay_wait, NULL);
+    assert(result.moves == 7);
+    assert(result.status == SIM_FINISHED);
+    assert(replay_waited_ms == 7 * 300 + 2); // sub-ms remainders carry over
+    pos_t karel = karel_sim_position();
+    assert(karel.x == 2 && karel.y == 2 && karel.dir == SOUTH);
+
+    // short pauses fit in one byte
+    replay_record_start(start, 0);
+    replay_record(TURN_LEFT, 15000);
+    assert(replay_size() == 1);
+
+    // loading the bytes of a dump gives the same replay
+    unsigned char data[] = {0x8c, 0x12, 0x8c, 0x12, 0x10};
+    assert(replay_load(start, data, 5) == 3);
+    result = replay_run(0, 0);
+    karel = karel_sim_position();
+    assert(karel.x == 2 && karel.y == 0 && karel.dir == NORTH);
+    assert(replay_load(start, data, 1) == -1);
+}
+
+static void step_and_journal(int move) {
+    assert(karel_sim_step(move) != SIM_BLOCKED);
+    assert(journal_push(move));
+}
+
+void test_journal(void) {
+
+    const char *board[3] = 
+    {
+        "---",
+        "---",
+        "--b",
+    };
+    board_init(board, 3, 3);
+
+    pos_t start = {0, 0, EAST};
+    karel_sim_init(start);
+    journal_init(start);
+
+    step_and_journal(MOVE_FORWARD);
+    step_and_journal(TURN_LEFT);
+    step_and_journal(TURN_LEFT);
+    step_and_journal(TURN_LEFT);
+    step_and_journal(MOVE_FORWARD);
+    assert(journal_step() == 5 && journal_length() == 5);
+    pos_t karel = karel_sim_position();
+    assert(karel.x == 1 && karel.y == 1 && karel.dir == SOUTH);
+
+    // back out of the south move and the last turn
+    assert(journal_undo() == MOVE_BACKWARD && journal_undo() == TURN_RIGHT);
+    karel = karel_sim_position();
+    assert(karel.x == 1 && karel.y == 0 && karel.dir == WEST);
+    assert(journal_redo() == TURN_LEFT);
+    assert(karel_sim_position().dir == SOUTH);
+
+    assert(journal_goto(0));
+    karel = karel_sim_position();
+    assert(karel.x == 0 && karel.y == 0 && karel.dir == EAST);
+    assert(journal_undo() == -1);
+    assert(journal_goto(5));
+    assert(karel_sim_position().y == 1);
+    assert(journal_redo() == -1);
+    assert(!journal_goto(6));
+
+    // a new move throws away what could be redone
+    assert(journal_goto(1));
+    step_and_journal(MOVE_FORWARD);
+    assert(journal_length() == 2 && journal_redo() == -1);
+    assert(karel_sim_position().x == 2);
+
+    // right turns are taken back with a left turn
+    step_and_journal(TURN_RIGHT);
+    step_and_journal(MOVE_FORWARD);
+    karel = karel_sim_position();
+    assert(karel.x == 2 && karel.y == 1 && karel.dir == SOUTH);
+    assert(journal_undo() == MOVE_BACKWARD && journal_undo() == TURN_LEFT);
+    karel = karel_sim_position();
+    assert(karel.x == 2 && karel.y == 0 && karel.dir == EAST);
+    assert(journal_redo() == TURN_RIGHT && karel_sim_position().dir == SOUTH);
+    assert(journal_goto(4) && journal_goto(2));
+    assert(karel_sim_position().dir == EAST);
+}
+
+void test_beepers(void) {
+
+    const char *board[3] = 
+    {
+        "b--",
+        "---",
+        "--b",
+    };
+    board_init(board, 3, 3);
+    assert(tiles_total_beepers() == 2 && tiles_count(BEEPER) == 2);
+
+    pos_t start = {0, 0, EAST};
+    karel_sim_init(start);
+    karel_sim_set_bag(0);
+    karel_sim_set_goal(GOAL_COLLECT_ALL);
+    journal_init(start);
+
+    // nothing to put down yet, then pick up the first beeper
+    assert(karel_sim_step(PUT_BEEPER) == SIM_BLOCKED);
+    assert(karel_sim_step(PICK_BEEPER) == SIM_OK);
+    assert(journal_push(PICK_BEEPER));
+    assert(karel_sim_bag() == 1 && !tiles_has_beeper(0, 0));
+    assert(tiles_total_beepers() == 1 && tiles_count(BEEPER) == 1);
+    assert(karel_sim_step(PICK_BEEPER) == SIM_BLOCKED);
+
+    // stack two beepers in the middle of the top row
+    assert(karel_sim_step(MOVE_FORWARD) == SIM_OK);
+    assert(journal_push(MOVE_FORWARD));
+    assert(karel_sim_step(PUT_BEEPER) == SIM_OK);
+    assert(journal_push(PUT_BEEPER));
+    assert(tiles_beepers(1, 0) == 1 && karel_sim_bag() == 0);
+    assert(tiles_add_beeper(1, 0));
+    assert(tiles_beepers(1, 0) == 2 && tiles_total_beepers() == 3);
+    assert(tiles_remove_beeper(1, 0));
+
+    // undo puts the beeper back in the bag, then back in the corner
+    assert(journal_undo() == PICK_BEEPER);
+    assert(tiles_beepers(1, 0) == 0 && karel_sim_bag() == 1);
+    assert(journal_goto(0));
+    assert(tiles_beepers(0, 0) == 1 && karel_sim_bag() == 0);
+    assert(journal_goto(3));
+    assert(tiles_beepers(0, 0) == 0 && tiles_beepers(1, 0) == 1);
+
+    // picking up every beeper wins
+    assert(karel_sim_step(PICK_BEEPER) == SIM_OK);
+    karel_sim_init((pos_t) {2, 2, EAST});
+    assert(karel_sim_step(PICK_BEEPER) == SIM_FINISHED);
+    assert(karel_sim_bag() == 2);
+
+    // the same from the Karel language
+    board_init(board, 3, 3);
+    karel_sim_init(start);
+    karel_sim_set_bag(0);
+    int entry = karel_compile("pick_beeper move move turn_left turn_left turn_left "
+                              "move move put_beeper pick_beeper pick_beeper");
+    assert(entry >= 0);
+    karel_vm_result_t result = karel_vm_run(karel_bytecode(), entry, 1000, NULL, 0);
+    assert(result.status == VM_FINISHED && result.actions == 11);
+    karel_sim_set_goal(GOAL_REACH_BEEPER);
+}
+
+static void count_call(void *aux) {
+    (*(int *) aux)++;
+}
+
+static int sched_order[3];
+static int sched_order_len;
+
+static void note_call(void *aux) {
+    sched_order[sched_order_len++] = (int) (long) aux;
+}
+
+/*
+ * Runs the scheduler on the simulated clock, across
+ * the point where the clock wraps around
+ */
+void test_sched(void) {
+    sched_init(0, 0);
+    sched_sim_set(0xffffff00);
+    unsigned int start = sched_now();
+
+    int once = 0, periodic = 0;
+    sched_add(start + 500, 0, count_call, &once);
+    int id = sched_add(start + 100, 100, count_call, &periodic);
+    sched_sleep_until(start + 1000);
+    assert(sched_now() == start + 1000);
+    assert(once == 1 && periodic == 10);
+
+    // a periodic callback that fell behind runs once
+    sched_sim_set(start + 5000);
+    assert(sched_run() == 1 && periodic == 11);
+    sched_cancel(id);
+    sched_sleep_ms(1);
+    assert(periodic == 11);
+
+    // earliest first, whatever order they were added in
+    start = sched_now();
+    sched_add(start + 300, 0, note_call, (void *) 3);
+    sched_add(start + 100, 0, note_call, (void *) 1);
+    sched_add(start + 200, 0, note_call, (void *) 2);
+    sched_sleep_ms(1);
+    assert(sched_order_len == 3);
+    assert(sched_order[0] == 1 && sched_order[1] == 2 && sched_order[2] == 3);
+
+    // the table fills up
+    for (int i = 0; i < SCHED_MAX_EVENTS; i++) {
+        assert(sched_add(start, 0, count_call, &once) >= 0);
+    }
+    assert(sched_add(start, 0, count_call, &once) == -1);
+    assert(sched_run() == SCHED_MAX_EVENTS);
+    sched_init(0, 0);
+}
+
+/*
+ * Checks fixed-point arithmetic on values with
+ * exact answers, and at its limits
+ */
+void test_fixed(void) {
+    fixed_t half = FIXED_ONE / 2;
+    assert(FIXED_TO_INT(FIXED_FROM_INT(-7)) == -7);
+    assert(fixed_mul(FIXED_FROM_INT(3), half) == FIXED_FROM_RATIO(3, 2));
+    assert(fixed_mul(FIXED_FROM_INT(-3), FIXED_FROM_INT(4)) == FIXED_FROM_INT(-12));
+    assert(fixed_div(FIXED_FROM_INT(3), FIXED_FROM_INT(4)) == FIXED_FROM_RATIO(3, 4));
+    assert(fixed_div(FIXED_FROM_INT(-1), FIXED_FROM_INT(8)) == -FIXED_ONE / 8);
+    assert(fixed_div(FIXED_ONE, 0) == FIXED_MAX && fixed_div(-FIXED_ONE, 0) == FIXED_MIN);
+    assert(fixed_div(FIXED_FROM_INT(30000), half / 2) == FIXED_MAX);
+
+    assert(fixed_add_sat(FIXED_FROM_INT(2), FIXED_FROM_INT(-5)) == FIXED_FROM_INT(-3));
+    assert(fixed_add_sat(FIXED_MAX, 1) == FIXED_MAX);
+    assert(fixed_add_sat(FIXED_MIN, -1) == FIXED_MIN);
+
+    assert(fixed_sqrt(FIXED_FROM_INT(9)) == FIXED_FROM_INT(3));
+    assert(fixed_sqrt(FIXED_ONE / 4) == half);
+    assert(fixed_sqrt(-FIXED_ONE) == 0);
+    assert(fixed_sqrt(FIXED_MAX) == 0xb504f3); // sqrt(32768)
+
+    // the angle is an approximation, so allow a few hundredths of a degree at the axes
+    fixed_t near = FIXED_ONE / 32;
+    fixed_t angles[][3] = {
+        {0, 1, 0}, {1, 1, 45}, {1, 0, 90}, {1, -1, 135},
+        {0, -1, 180}, {-1, -1, -135}, {-1, 0, -90}, {-1, 1, -45},
+    };
+    for (int i = 0; i < sizeof(angles) / sizeof(angles[0]); i++) {
+        fixed_t angle = fixed_atan2(FIXED_FROM_INT(angles[i][0]), FIXED_FROM_INT(angles[i][1]));
+        fixed_t error = angle - FIXED_FROM_INT(angles[i][2]);
+        assert(error < near && error > -near);
+    }
+    assert(fixed_atan2(0, 0) == 0);
+}
+
+/*
+ * Calibrates from made-up samples at rest, moving
+ * and tilted
+ */
+void test_calibration(void) {
+    static sensor_sample_t samples[64];
+    calibration_t cal;
+
+    // readings off by a fixed amount, alternating by +-20
+    for (int i = 0; i < 64; i++) {
+        int d = i % 2 ? 20 : -20;
+        samples[i] = (sensor_sample_t) {{-300 + d, 50 + d, 120 + d},
+                                        {400 + d, -100 + d, CALIBRATION_ONE_G + 200 + d}};
+    }
+    assert(calibration_compute(samples, 64, &cal));
+    assert(cal.gyro_bias[0] == -300 && cal.gyro_bias[1] == 50 && cal.gyro_bias[2] == 120);
+    assert(cal.accel_bias[0] == 400 && cal.accel_bias[1] == -100 && cal.accel_bias[2] == 200);
+    for (int axis = 0; axis < 3; axis++) {
+        assert(cal.gyro_noise[axis] == 20 && cal.accel_noise[axis] == 20);
+    }
+    assert(!calibration_compute(samples, 8, &cal)); // too few
+
+    calibration_t kept = cal;
+    samples[10].gyro[2] = 20000; // a knock
+    assert(!calibration_compute(samples, 64, &cal));
+    assert(cal.gyro_bias[2] == kept.gyro_bias[2]);
+
+    samples[10].gyro[2] = 120;
+    for (int i = 0; i < 64; i++) {
+        samples[i].accel[0] += CALIBRATION_ONE_G / 2; // tilted about 30 degrees
+    }
+    assert(!calibration_compute(samples, 64, &cal));
+}
+
+/*
+ * Fills and empties the move queue, across the point
+ * where its indexes pass the queue's size
+ */
+void test_move_queue(void) {
+    move_queue_clear();
+    assert(move_queue_pop() == -1);
+
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < MOVE_QUEUE_SIZE; i++) {
+            assert(move_queue_push(i % 2 ? TURN_LEFT : MOVE_FORWARD));
+        }
+        int dropped = move_queue_dropped();
+        assert(!move_queue_push(PICK_BEEPER));
+        assert(move_queue_dropped() == dropped + 1);
+        assert(move_queue_count() == MOVE_QUEUE_SIZE);
+
+        for (int i = 0; i < MOVE_QUEUE_SIZE - 2; i++) {
+            assert(move_queue_pop() == (i % 2 ? TURN_LEFT : MOVE_FORWARD));
+        }
+        assert(move_queue_count() == 2);
+        move_queue_clear();
+        assert(move_queue_count() == 0 && move_queue_pop() == -1);
+    }
+}
+
+// a source that has a turn waiting until flushed
+static int turns_waiting;
+
+static int turns_init(void) {
+    turns_waiting = 1;
+    return 1;
+}
+
+static int turns_poll(void) {
+    return turns_waiting ? TURN_LEFT : -1;
+}
+
+static void turns_flush(void) {
+    turns_waiting = 0;
+}
+
+static const input_source_t turns = {"turns", turns_init, turns_poll, turns_flush};
+
+// a source whose device is not there
+static int missing_init(void) {
+    return 0;
+}
+
+static const input_source_t missing = {"missing", missing_init, turns_poll, 0};
+
+/*
+ * Plays a script alongside a source that always has
+ * a move, and checks neither starves the other
+ */
+void test_input(void) {
+    static const unsigned char script[] = {MOVE_FORWARD, PICK_BEEPER, MOVE_BACKWARD};
+
+    input_init();
+    assert(input_poll() == -1);
+    assert(!input_add(&missing));
+
+    input_script_load(script, 3);
+    assert(input_add(&input_script));
+    assert(input_add(&turns) && turns_waiting);
+    assert(input_script_left() == 3);
+
+    for (int i = 0; i < 3; i++) {
+        assert(input_poll() == script[i]);
+        assert(input_poll() == TURN_LEFT);
+    }
+    assert(input_script_left() == 0);
+    assert(input_read() == TURN_LEFT);
+
+    input_flush();
+    assert(input_poll() == -1);
+
+    input_script_load(script, 3); // flushing leaves scripts alone
+    input_flush();
+    assert(input_read() == MOVE_FORWARD);
+
+    for (int i = 2; i < INPUT_MAX_SOURCES; i++) {
+        assert(input_add(&turns));
+    }
+    assert(!input_add(&turns));
+}
+
 void test_accel_gyro(void) {
 
-    accel_init();
+    assert(accel_init());
     while (1) {
 
         int move = accel_read_move();
@@ -73,7 +826,131 @@ void test_accel_gyro(void) {
     }
 }
 
+/*
+ * Times sensor samples read one register at a time
+ * against ones read in a single burst
+ */
+void test_sensor_burst(void) {
+    assert(accel_init());
+    short gyro[3], accel[3];
+
+    unsigned long long start = timer_get_ticks64();
+    for (int i = 0; i < 100; i++) {
+        for (int reg = OUTX_L_G; reg <= OUTZ_H_XL; reg++) {
+            lsm6ds33_read_reg(reg);
+        }
+    }
+    unsigned int by_register = timer_get_ticks64() - start;
+
+    start = timer_get_ticks64();
+    for (int i = 0; i < 100; i++) {
+        lsm6ds33_read_sample(gyro, accel);
+    }
+    unsigned int burst = timer_get_ticks64() - start;
+
+    printf("100 samples: %d us by register, %d us in bursts\n", by_register, burst);
+    printf("last sample: gyro %d %d %d, accel %d %d %d\n",
+           gyro[0], gyro[1], gyro[2], accel[0], accel[1], accel[2]);
+    assert(burst < by_register);
+}
+
+static void print_latencies(const char *label) {
+    unsigned int counts[I2C_LATENCY_BUCKETS];
+    i2c_latency_histogram(counts);
+    printf("%s:", label);
+    for (int i = 0; i < I2C_LATENCY_BUCKETS; i++) {
+        if (counts[i]) printf(" %d-%dus %d", 1 << i, (2 << i) - 1, counts[i]);
+    }
+    printf("\n");
+}
+
+/*
+ * Times sample reads at both bus speeds, from the
+ * transfer latency histogram
+ */
+void test_i2c_latency(void) {
+    assert(accel_init());
+    short gyro[3], accel[3];
+
+    int speeds[] = {I2C_STANDARD_HZ, I2C_FAST_HZ};
+    unsigned int elapsed[2];
+    for (int s = 0; s < 2; s++) {
+        i2c_set_clock(speeds[s]);
+        i2c_latency_reset();
+        unsigned long long start = timer_get_ticks64();
+        for (int i = 0; i < 100; i++) {
+            lsm6ds33_read_sample(gyro, accel);
+        }
+        elapsed[s] = timer_get_ticks64() - start;
+        print_latencies(s ? "400 kHz" : "100 kHz");
+    }
+    i2c_set_clock(I2C_STANDARD_HZ);
+
+    // no peripheral at this address
+    char byte = 0;
+    assert(i2c_write(0x7f, &byte, 1) == I2C_NACK);
+
+    printf("100 samples: %d us at 100 kHz, %d us at 400 kHz\n", elapsed[0], elapsed[1]);
+    assert(elapsed[1] < elapsed[0]);
+}
+
+/*
+ * Counts I2C transfers over a second of polling as
+ * fast as possible: with INT1 starting the drains,
+ * the bus is only used when samples are ready.
+ * Without INT1 every poll drains, so there is no
+ * bound to check.
+ */
+void test_sensor_traffic(void) {
+    assert(accel_init());
+    i2c_latency_reset();
+
+    int polls = 0;
+    unsigned int start = timer_get_ticks();
+    while (timer_get_ticks() - start < 1000000) {
+        accel_poll_move();
+        polls++;
+    }
+
+    unsigned int counts[I2C_LATENCY_BUCKETS];
+    i2c_latency_histogram(counts);
+    int transfers = 0;
+    for (int i = 0; i < I2C_LATENCY_BUCKETS; i++) {
+        transfers += counts[i];
+    }
+    printf("%d polls in a second, %d I2C transfers, %s\n", polls, transfers,
+           accel_uses_int1() ? "drained on INT1" : "drained on each poll");
+    if (accel_uses_int1()) {
+        assert(transfers < 200); // about 26 drains of a few transfers each
+    }
+}
+
+/*
+ * Checks the 64-bit clock against the 32-bit one
+ * and measures the cycle counter against both
+ */
+void test_timer(void) {
+    unsigned long long last = timer_get_ticks64();
+    for (int i = 0; i < 100000; i++) {
+        unsigned long long now = timer_get_ticks64();
+        assert(now >= last);
+        last = now;
+    }
+    assert(timer_get_ticks() - (unsigned int) last < 1000);
+
+    unsigned int start_cycles = timer_get_cycles();
+    unsigned long long start = timer_get_ticks64();
+    timer_delay_ms(10);
+    unsigned int cycles = timer_get_cycles() - start_cycles;
+    unsigned int elapsed = timer_get_ticks64() - start;
+
+    printf("%d cycles in %d us (%d MHz)\n", cycles, elapsed, cycles / elapsed);
+    assert(cycles / elapsed > TIMER_CYCLES_PER_US * 9 / 10);
+    assert(cycles / elapsed < TIMER_CYCLES_PER_US * 11 / 10);
+}
+
 void test_karel_world(void) {
+    sched_init(timer_get_ticks, timer_idle); // update_karel_world sleeps between frames
     karel_world_init();
     while (1) {
         update_karel_world();
@@ -90,7 +967,30 @@ void main(void)
     timer_init();
     test_board();
     test_complex_board();
+    test_board_animation();
+    test_walls();
+    test_tiles();
+    test_solver();
+    bench_solver();
+    test_distfield();
+    bench_distfield();
+    test_maze();
+    bench_maze();
+    test_script();
+    test_karel_vm();
+    test_replay();
+    test_journal();
+    test_beepers();
+    test_sched();
+    test_fixed();
+    test_calibration();
+    test_move_queue();
+    test_input();
    
+    test_timer();
+    test_sensor_burst();
+    test_i2c_latency();
+    test_sensor_traffic();
     test_accel_gyro();
     test_karel_world();
     test_game(); 